@@ -0,0 +1,288 @@
+////////////////////////////////////////////////////////////
+// Headless search benchmark
+//
+// Builds synthetic graphs (see GraphGenerators.hpp), runs UCS, A* and
+// precomputed A* over the same fixed query set on each, and writes the
+// results as JSON. Nothing is drawn, only sf::Vector2f is used from
+// SFML so no SFML libraries are linked.
+//
+// Benchmark [--nodes N] [--queries Q] [--seed S] [--degree D]
+//           [--links L] [--obstacles F] [--graphs geometric,grid,scalefree]
+//           [--map table|lazy|auto] [--out file.json]
+////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Graph.hpp"
+#include "GraphGenerators.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+typedef Graph<int, int> BenchGraph;
+typedef std::chrono::steady_clock BenchClock;
+
+struct Options {
+	int nodes;
+	int queries;
+	unsigned seed;
+	float degree; //Average degree of the geometric graph
+	int links; //Arcs added per node in the scale free graph
+	float obstacles; //Share of blocked grid cells
+	string graphs;
+	string map; //table, lazy or auto
+	string out;
+
+	Options() : nodes(10000), queries(200), seed(1), degree(8), links(3), obstacles(0.25f),
+		graphs("geometric,grid,scalefree"), map("auto") {}
+};
+
+//Results of one search over the query set
+struct SearchResult {
+	string search;
+	double prepMs; //One off preprocessing, genMap for the map search
+	long long prepNodes; //Nodes touched by per query set up, see runSearch
+	long long settled;
+	long long relaxed;
+	int reached;
+	double seconds;
+	vector<double> latencies; //Microseconds per query
+};
+
+double msSince(BenchClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+//Nearest rank percentile of sorted values
+double percentile(vector<double> const & sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+
+	size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << arg << endl;
+			return false;
+		}
+
+		string value = argv[++i];
+		if (arg == "--nodes") options.nodes = atoi(value.c_str());
+		else if (arg == "--queries") options.queries = atoi(value.c_str());
+		else if (arg == "--seed") options.seed = (unsigned)strtoul(value.c_str(), 0, 10);
+		else if (arg == "--degree") options.degree = (float)atof(value.c_str());
+		else if (arg == "--links") options.links = atoi(value.c_str());
+		else if (arg == "--obstacles") options.obstacles = (float)atof(value.c_str());
+		else if (arg == "--graphs") options.graphs = value;
+		else if (arg == "--map") options.map = value;
+		else if (arg == "--out") options.out = value;
+		else
+		{
+			std::cerr << "Unknown option " << arg << endl;
+			return false;
+		}
+	}
+
+	return options.nodes > 1 && options.queries > 0;
+}
+
+//Start and target pairs over existing nodes, the same for every search on a graph
+vector<std::pair<int, int>> makeQueries(BenchGraph const & graph, int count, unsigned seed)
+{
+	GraphRandom random(seed);
+	vector<int> ids;
+	for (int i = 0; i < graph.slotCount(); ++i)
+	{
+		if (graph.exists(i))
+			ids.push_back(i);
+	}
+
+	vector<std::pair<int, int>> queries;
+	for (int q = 0; q < count; ++q)
+		queries.push_back(std::make_pair(ids[random.uniform((int)ids.size())], ids[random.uniform((int)ids.size())]));
+
+	return queries;
+}
+
+// ----------------------------------------------------------------
+//  Name:           runSearch
+//  Description:    Runs one search over the query set. Each query is
+//                  timed on its own, including any per query set up
+//                  (InitAStar's UCS for A*, mapNodes for the map),
+//                  just as the node based searches do it. The set up
+//                  is counted apart from the search, as nodes settled
+//                  by InitAStar's UCS or given an H by mapNodes, so
+//                  settled stays comparable between searches.
+//  Arguments:      The graph, compacted
+//                  The search: UCS, AStar or AStarPrecomp
+//                  The queries
+//                  The map mode for AStarPrecomp.
+//  Return Value:   The measurements.
+// ----------------------------------------------------------------
+SearchResult runSearch(BenchGraph& graph, string const & search, vector<std::pair<int, int>> const & queries, bool lazyMap)
+{
+	SearchResult result;
+	result.search = search;
+	result.prepMs = 0;
+	result.prepNodes = 0;
+	result.reached = 0;
+
+	if (search == "AStarPrecomp")
+	{
+		BenchClock::time_point start = BenchClock::now();
+		graph.genMap(lazyMap);
+		result.prepMs = msSince(start);
+	}
+
+	SearchContext<int> ctx(graph.slotCount());
+	CountTrace trace;
+	CountTrace prepTrace;
+
+	BenchClock::time_point all = BenchClock::now();
+	for (size_t q = 0; q < queries.size(); ++q)
+	{
+		int from = queries[q].first;
+		int to = queries[q].second;
+
+		BenchClock::time_point start = BenchClock::now();
+		if (search == "UCS")
+			graph.UCS(ctx, from, to, trace);
+		else if (search == "AStar")
+		{
+			graph.InitAStar(ctx, to, prepTrace);
+			graph.AStar(ctx, from, to, StoredHeuristic<int>(ctx), trace);
+		}
+		else
+		{
+			graph.mapNodes(ctx, to);
+			result.prepNodes += graph.count();
+			graph.AStar(ctx, from, to, StoredHeuristic<int>(ctx), trace);
+		}
+		result.latencies.push_back(msSince(start) * 1000.0);
+
+		if (from == to || ctx.prev(to) != -1)
+			++result.reached;
+	}
+	result.seconds = msSince(all) / 1000.0;
+	result.prepNodes += prepTrace.settled;
+	result.settled = trace.settled;
+	result.relaxed = trace.relaxed;
+
+	std::sort(result.latencies.begin(), result.latencies.end());
+	return result;
+}
+
+void writeResult(std::ostream& json, string const & graphName, BenchGraph& graph, double buildMs, bool lazyMap, SearchResult const & r, bool first)
+{
+	double count = (double)r.latencies.size();
+
+	json << (first ? "" : ",\n") << "    {"
+		<< "\"graph\": \"" << graphName << "\", "
+		<< "\"nodes\": " << graph.count() << ", "
+		<< "\"arcs\": " << graph.csr().arcCount() << ", "
+		<< "\"build_ms\": " << buildMs << ", "
+		<< "\"search\": \"" << r.search << "\", ";
+
+	if (r.search == "AStarPrecomp")
+		json << "\"map\": \"" << (lazyMap ? "lazy" : "table") << "\", ";
+
+	json << "\"prep_ms\": " << r.prepMs << ", "
+		<< "\"queries\": " << r.latencies.size() << ", "
+		<< "\"reached\": " << r.reached << ", "
+		<< "\"prep_nodes_total\": " << r.prepNodes << ", "
+		<< "\"prep_nodes_mean\": " << r.prepNodes / count << ", "
+		<< "\"settled_total\": " << r.settled << ", "
+		<< "\"settled_mean\": " << r.settled / count << ", "
+		<< "\"relaxed_mean\": " << r.relaxed / count << ", "
+		<< "\"qps\": " << (r.seconds > 0 ? count / r.seconds : 0) << ", "
+		<< "\"p50_us\": " << percentile(r.latencies, 50) << ", "
+		<< "\"p99_us\": " << percentile(r.latencies, 99) << "}";
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << "Usage: Benchmark [--nodes N] [--queries Q] [--seed S] [--degree D] [--links L] "
+			"[--obstacles F] [--graphs geometric,grid,scalefree] [--map table|lazy|auto] [--out file.json]" << endl;
+		return 1;
+	}
+
+	std::ostringstream json;
+	json << "{\n  \"seed\": " << options.seed << ",\n  \"queries\": " << options.queries << ",\n  \"results\": [\n";
+
+	const char* searches[] = { "UCS", "AStar", "AStarPrecomp" };
+	bool first = true;
+
+	std::stringstream names(options.graphs);
+	string name;
+	while (std::getline(names, name, ','))
+	{
+		BenchGraph graph;
+		graph.setVerbosity(0);
+
+		BenchClock::time_point start = BenchClock::now();
+		if (name == "geometric")
+			generateGeometric(graph, options.nodes, options.degree, options.seed);
+		else if (name == "grid")
+		{
+			int side = (int)std::ceil(std::sqrt((double)options.nodes));
+			generateGrid(graph, side, side, options.obstacles, options.seed);
+		}
+		else if (name == "scalefree")
+			generateScaleFree(graph, options.nodes, options.links, options.seed);
+		else
+		{
+			std::cerr << "Unknown graph " << name << endl;
+			return 1;
+		}
+		double buildMs = msSince(start);
+
+		//The half table is n * n / 2 floats, past 64MB work distances out on lookup
+		bool lazyMap = options.map == "lazy" ||
+			(options.map == "auto" && (double)graph.slotCount() * graph.slotCount() * 2 > 64.0 * 1024 * 1024);
+
+		vector<std::pair<int, int>> queries = makeQueries(graph, options.queries, options.seed + 1);
+
+		for (int s = 0; s < 3; ++s)
+		{
+			SearchResult result = runSearch(graph, searches[s], queries, lazyMap);
+			writeResult(json, name, graph, buildMs, lazyMap, result, first);
+			first = false;
+
+			std::cerr << name << " " << searches[s] << " done" << endl;
+		}
+	}
+
+	json << "\n  ]\n}\n";
+
+	if (options.out.empty())
+		cout << json.str();
+	else
+	{
+		std::ofstream file(options.out.c_str());
+		file << json.str();
+	}
+
+	return 0;
+}
@@ -0,0 +1,254 @@
+#ifndef ANYTIMESEARCH_H
+#define ANYTIMESEARCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "SearchContext.hpp"
+#include "SearchBudget.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           AnytimeSearch
+//  Description:    Anytime repairing A* (ARA*, Likhachev, Gordon and
+//                  Thrun). Nodes are queued on g + w * h, so with an
+//                  inflated weight w > 1 a route comes back quickly and
+//                  costs at most w times the cheapest. Each improve()
+//                  then lowers w by a step and carries on from where
+//                  the last one stopped: g and previous are kept, and
+//                  nodes improved after they were expanded wait on an
+//                  inconsistent list instead of being expanded again
+//                  in the same pass. At w = 1 the route is optimal.
+//
+//                  Each solution's bound is the tighter of w and
+//                      cost / min(g + h) over the open and inconsistent
+//                  nodes, as no route left unexplored can be cheaper
+//                  than that minimum.
+//  Arguments:      The heuristic gives the H of a node index for this
+//                  target, see Heuristics.hpp, and must be consistent.
+// ----------------------------------------------------------------
+template<class ArcType, class Heuristic>
+class AnytimeSearch {
+public:
+	struct Solution {
+		float weight; //Inflation the pass ran with
+		float bound; //Cost is at most bound times the cheapest
+		ArcType cost;
+		int expanded; //Nodes expanded by the pass
+		double seconds; //Since the first pass began
+	};
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	Heuristic m_heuristic;
+	SearchContext<ArcType> m_ctx; //g, previous, h and the open list
+
+	std::vector<unsigned> m_closed; //Pass that expanded each node
+	std::vector<int> m_incons; //Improved after being expanded this pass
+	std::vector<char> m_inIncons;
+	std::vector<int> m_scratch;
+
+	int m_start;
+	int m_target;
+	float m_weight;
+	float m_step;
+	unsigned m_pass; //Counts from 1, 0 is never expanded
+	int m_expanded; //In the pass under way
+	bool m_started;
+
+	Clock::time_point m_begun;
+	std::vector<Solution> m_solutions;
+	std::vector<int> m_path; //Route of the last solution, start first
+
+	float h(int node);
+	float lowerBound(float weight);
+	template<class Adjacency> void begin(Adjacency const & adj);
+
+public:
+	AnytimeSearch(int start, int target, Heuristic heuristic, float weight, float step = 0.5f);
+
+	//Runs a pass, or carries on one a budget stopped, true if it gave a new solution
+	template<class Adjacency>
+	bool improve(Adjacency const & adj, SearchBudget const & budget = SearchBudget());
+
+	// Accessors
+	float weight() const { return m_weight; }
+	bool found() const { return !m_solutions.empty(); }
+	bool optimal() const { return found() && m_solutions.back().bound <= 1; }
+	Solution const & best() const { return m_solutions.back(); }
+	std::vector<Solution> const & solutions() const { return m_solutions; }
+	SearchContext<ArcType> const & context() const { return m_ctx; }
+
+	//Route of the last solution, empty if there isn't one. A pass under way doesn't change it
+	void getPath(std::vector<int>& path) const { path = m_path; }
+};
+
+template<class ArcType, class Heuristic>
+AnytimeSearch<ArcType, Heuristic>::AnytimeSearch(int start, int target, Heuristic heuristic, float weight, float step) :
+	m_heuristic(heuristic), m_start(start), m_target(target), m_weight(weight < 1 ? 1 : weight), m_step(step > 0 ? step : 1),
+	m_pass(1), m_expanded(0), m_started(false)
+{
+}
+
+//H of a node, asked of the heuristic once and kept in the context
+template<class ArcType, class Heuristic>
+float AnytimeSearch<ArcType, Heuristic>::h(int node)
+{
+	float value = m_ctx.h(node);
+	if (value == m_ctx.maxH())
+	{
+		value = m_heuristic(node);
+		m_ctx.setH(node, value);
+	}
+
+	return value;
+}
+
+template<class ArcType, class Heuristic>
+template<class Adjacency>
+void AnytimeSearch<ArcType, Heuristic>::begin(Adjacency const & adj)
+{
+	m_ctx.resize(adj.nodeCount());
+	m_ctx.reset();
+	m_ctx.resetH();
+	m_closed.assign(adj.nodeCount(), 0);
+	m_inIncons.assign(adj.nodeCount(), 0);
+
+	m_ctx.setG(m_start, 0);
+	m_ctx.setMarked(m_start, true);
+	m_ctx.open().push(m_start, m_weight * h(m_start));
+
+	m_begun = Clock::now();
+	m_started = true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           lowerBound
+//  Description:    Moves the inconsistent nodes back onto the open
+//                  list and requeues everything on it at a new weight.
+//                  The heap is keyed by node, so it's emptied and
+//                  refilled rather than rekeyed in place.
+//  Arguments:      The weight for the next pass.
+//  Return Value:   Lowest g + h of the requeued nodes, max H if none.
+// ----------------------------------------------------------------
+template<class ArcType, class Heuristic>
+float AnytimeSearch<ArcType, Heuristic>::lowerBound(float weight)
+{
+	IndexedHeap<float>& open = m_ctx.open();
+
+	m_scratch.clear();
+	while (!open.empty())
+		m_scratch.push_back(open.pop());
+
+	for (size_t i = 0; i < m_incons.size(); ++i)
+	{
+		m_scratch.push_back(m_incons[i]);
+		m_inIncons[m_incons[i]] = 0;
+	}
+	m_incons.clear();
+
+	float lowest = m_ctx.maxH();
+	for (size_t i = 0; i < m_scratch.size(); ++i)
+	{
+		int node = m_scratch[i];
+		float g = (float)m_ctx.g(node);
+
+		if (g + h(node) < lowest)
+			lowest = g + h(node);
+		open.push(node, g + weight * h(node));
+	}
+
+	return lowest;
+}
+
+// ----------------------------------------------------------------
+//  Name:           improve
+//  Description:    Expands nodes at the current weight until nothing
+//                  left on the open list could give a cheaper route to
+//                  the target. Finishing a pass records a solution,
+//                  lowers the weight and requeues for the next pass. A
+//                  budget that runs out stops the pass where it is,
+//                  and the next call carries on with it.
+//  Arguments:      The first parameter is the adjacency to search
+//                  The second limits this call, see SearchBudget.hpp.
+//  Return Value:   True if a pass finished with a route. False if the
+//                  budget ran out, there's no route, or the last
+//                  solution was already optimal.
+// ----------------------------------------------------------------
+template<class ArcType, class Heuristic>
+template<class Adjacency>
+bool AnytimeSearch<ArcType, Heuristic>::improve(Adjacency const & adj, SearchBudget const & budget)
+{
+	if (!m_started)
+		begin(adj);
+	else if (optimal())
+		return false;
+
+	IndexedHeap<float>& open = m_ctx.open();
+	int checked = 0;
+
+	//The target's key is just g, h is 0 there
+	while (!open.empty() && (float)m_ctx.g(m_target) > open.topKey())
+	{
+		if (budget.check(checked++, (float)m_ctx.g(open.top())) != Complete)
+			return false;
+
+		int top = open.pop();
+		m_closed[top] = m_pass;
+		++m_expanded;
+
+		for (int arc = adj.begin(top), endArc = adj.end(top); arc != endArc; ++arc)
+		{
+			int child = adj.target(arc);
+			ArcType gn = m_ctx.g(top) + adj.weight(arc);
+
+			if (gn < m_ctx.g(child))
+			{
+				m_ctx.setG(child, gn);
+				m_ctx.setPrev(child, top);
+				m_ctx.setMarked(child, true);
+
+				//Expanded this pass already, it waits for the next one
+				if (m_closed[child] != m_pass)
+					open.pushOrDecrease(child, gn + m_weight * h(child));
+				else if (!m_inIncons[child])
+				{
+					m_inIncons[child] = 1;
+					m_incons.push_back(child);
+				}
+			}
+		}
+	}
+
+	if (m_ctx.g(m_target) >= m_ctx.maxG())
+		return false;
+
+	Solution solution;
+	solution.weight = m_weight;
+	solution.cost = m_ctx.g(m_target);
+	solution.expanded = m_expanded;
+	solution.seconds = std::chrono::duration<double>(Clock::now() - m_begun).count();
+
+	//Kept apart, the next pass moves previous indices about before it finishes
+	m_path.clear();
+	for (int node = m_target; node != -1; node = m_ctx.prev(node))
+		m_path.push_back(node);
+	std::reverse(m_path.begin(), m_path.end());
+
+	//Next pass, its open list also gives this solution's bound
+	m_weight = m_weight - m_step > 1 ? m_weight - m_step : 1;
+	++m_pass;
+	m_expanded = 0;
+
+	float lowest = lowerBound(m_weight);
+	float ratio = solution.cost <= 0 ? 1 : lowest > 0 ? (float)solution.cost / lowest : solution.weight;
+	solution.bound = ratio < solution.weight ? ratio : solution.weight;
+	if (solution.bound < 1)
+		solution.bound = 1;
+
+	m_solutions.push_back(solution);
+	return true;
+}
+
+#endif
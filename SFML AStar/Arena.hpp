@@ -0,0 +1,189 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// ----------------------------------------------------------------
+//  Name:           SlabPool
+//  Description:    Hands out fixed size blocks carved from large
+//                  slabs. Freed blocks go on a free list and are
+//                  handed out again first. Each new slab is twice the
+//                  size of the last, so a graph of n arcs costs about
+//                  log(n) allocations, and blocks handed out in a row
+//                  sit next to each other in memory.
+// ----------------------------------------------------------------
+class SlabPool {
+private:
+	size_t m_blockSize; //Bytes per block, at least a pointer
+	size_t m_nextSlab; //Blocks in the next slab
+	std::vector<char*> m_slabs; //Every slab, freed on release()
+	void* m_free; //Free list, threaded through the freed blocks
+	char* m_next; //Next unused block in the newest slab
+	char* m_end; //End of the newest slab
+
+	SlabPool(SlabPool const &);
+	SlabPool& operator=(SlabPool const &);
+
+public:
+	explicit SlabPool(size_t blockSize, size_t firstSlab = 256) :
+		m_blockSize(blockSize < sizeof(void*) ? sizeof(void*) : (blockSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*)),
+		m_nextSlab(firstSlab), m_free(0), m_next(0), m_end(0) {}
+	~SlabPool() { release(); }
+
+	size_t blockSize() const { return m_blockSize; }
+
+	//Make sure the next blocks count blocks come from a single slab
+	void reserve(size_t count);
+
+	void* allocate();
+	void deallocate(void* p);
+
+	//Free every slab at once, blocks still out become invalid
+	void release();
+};
+
+inline void SlabPool::reserve(size_t count)
+{
+	if ((size_t)(m_end - m_next) / m_blockSize >= count)
+		return;
+
+	if (m_nextSlab < count)
+		m_nextSlab = count;
+
+	//Whatever is left of the current slab is given up
+	m_next = m_end = 0;
+}
+
+inline void* SlabPool::allocate()
+{
+	if (m_free)
+	{
+		void* p = m_free;
+		m_free = *(void**)p;
+		return p;
+	}
+
+	if (m_next == m_end)
+	{
+		m_slabs.push_back(static_cast<char*>(::operator new(m_nextSlab * m_blockSize)));
+		m_next = m_slabs.back();
+		m_end = m_next + m_nextSlab * m_blockSize;
+		m_nextSlab *= 2;
+	}
+
+	void* p = m_next;
+	m_next += m_blockSize;
+	return p;
+}
+
+inline void SlabPool::deallocate(void* p)
+{
+	*(void**)p = m_free;
+	m_free = p;
+}
+
+inline void SlabPool::release()
+{
+	for (size_t i = 0; i < m_slabs.size(); ++i)
+		::operator delete(m_slabs[i]);
+
+	m_slabs.clear();
+	m_free = 0;
+	m_next = m_end = 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           Arena
+//  Description:    One SlabPool per block size, for containers whose
+//                  node types (and so sizes) aren't known up front,
+//                  such as the nodes of GraphNode's arc list.
+//                  Not thread safe, like the graph that owns it.
+// ----------------------------------------------------------------
+class Arena {
+private:
+	std::vector<SlabPool*> m_pools;
+
+	Arena(Arena const &);
+	Arena& operator=(Arena const &);
+
+public:
+	Arena() {}
+	~Arena()
+	{
+		for (size_t i = 0; i < m_pools.size(); ++i)
+			delete m_pools[i];
+	}
+
+	//Pool for blocks of size bytes, made the first time it's asked for
+	SlabPool& pool(size_t size)
+	{
+		for (size_t i = 0; i < m_pools.size(); ++i)
+		{
+			if (m_pools[i]->blockSize() >= size && m_pools[i]->blockSize() - size < sizeof(void*))
+				return *m_pools[i];
+		}
+
+		m_pools.push_back(new SlabPool(size));
+		return *m_pools.back();
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           ArenaAllocator
+//  Description:    Standard allocator drawing single objects from an
+//                  Arena. Arrays, and everything when there is no
+//                  arena, go to the heap as usual.
+// ----------------------------------------------------------------
+template<class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef T const * const_pointer;
+	typedef T& reference;
+	typedef T const & const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U> struct rebind { typedef ArenaAllocator<U> other; };
+
+	Arena* pArena;
+
+	ArenaAllocator() : pArena(0) {}
+	explicit ArenaAllocator(Arena* pArena) : pArena(pArena) {}
+	template<class U> ArenaAllocator(ArenaAllocator<U> const & other) : pArena(other.pArena) {}
+
+	pointer address(reference r) const { return &r; }
+	const_pointer address(const_reference r) const { return &r; }
+	size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+	pointer allocate(size_type n, void const * = 0)
+	{
+		if (pArena && n == 1)
+			return static_cast<pointer>(pArena->pool(sizeof(T)).allocate());
+
+		return static_cast<pointer>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(pointer p, size_type n)
+	{
+		if (pArena && n == 1)
+			pArena->pool(sizeof(T)).deallocate(p);
+		else ::operator delete(p);
+	}
+
+	void construct(pointer p, const_reference value) { new((void*)p) T(value); }
+	template<class U, class... Args> void construct(U* p, Args&&... args) { new((void*)p) U(std::forward<Args>(args)...); }
+	template<class U> void destroy(U* p) { p->~U(); }
+};
+
+template<class T, class U>
+bool operator==(ArenaAllocator<T> const & a, ArenaAllocator<U> const & b) { return a.pArena == b.pArena; }
+
+template<class T, class U>
+bool operator!=(ArenaAllocator<T> const & a, ArenaAllocator<U> const & b) { return a.pArena != b.pArena; }
+
+#endif
@@ -0,0 +1,596 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Graph.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           ContractionHierarchy
+//  Description:    Preprocessed copy of a static graph for fast exact
+//                  queries. Nodes are contracted one at a time, least
+//                  important first, adding a shortcut arc wherever a
+//                  shortest route ran through the removed node. Every
+//                  arc ends up going up the order (upward graph) or
+//                  coming down it (kept turned around as the downward
+//                  graph), so a query is two small searches that only
+//                  ever climb and meet at the top of the route.
+//                  The graph must outlive the hierarchy and must be
+//                  rebuilt after it changes.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class ContractionHierarchy {
+private:
+	typedef GraphNode<NodeType, ArcType> Node;
+
+	//Arc in the working graph, middle is the contracted node of a shortcut or -1
+	struct Edge {
+		int node;
+		ArcType weight;
+		int middle;
+	};
+
+	typedef std::vector<std::vector<Edge>> EdgeLists;
+
+	Node* const * m_pNodes; //Node array of the graph the hierarchy was built from
+	int m_nodes; //Node slots covered
+
+	std::vector<int> m_rank; //Contraction order of each node
+
+	GraphCSR<ArcType> m_up; //Arcs to higher ranked nodes
+	std::vector<int> m_upMiddle; //Middle node of each upward arc, -1 if not a shortcut
+	GraphCSR<ArcType> m_down; //Arcs from higher ranked nodes, turned around
+	std::vector<int> m_downMiddle; //Middle node of each downward arc, -1 if not a shortcut
+
+	int m_shortcuts; //Shortcuts added by the last build
+	int m_witnessLimit; //Nodes a witness search may settle before giving up
+
+	SearchContext<ArcType> m_forward; //Query state for the upward search
+	SearchContext<ArcType> m_backward; //Query state for the downward search
+
+	int m_verbosity;
+
+public:
+	ContractionHierarchy() : m_pNodes(0), m_nodes(0), m_shortcuts(0), m_witnessLimit(500), m_verbosity(1) {}
+
+	// Accessors
+	bool empty() const { return m_nodes == 0; }
+	int nodeCount() const { return m_nodes; }
+	int shortcutCount() const { return m_shortcuts; }
+	int rank(int node) const { return m_rank[node]; }
+	GraphCSR<ArcType> const & up() const { return m_up; }
+	GraphCSR<ArcType> const & down() const { return m_down; }
+
+	//Lower is faster to build with more shortcuts, higher the opposite
+	void setWitnessLimit(int limit) { m_witnessLimit = limit; }
+	void setVerbosity(int verbosity) { m_verbosity = verbosity; }
+	void setSearchBudget(SearchBudget const & budget) { m_forward.setBudget(budget); } //For the node based query
+	SearchStatus searchStatus() const { return m_forward.status(); }
+
+	void clear();
+
+	//Contract every node of the graph
+	void build(Graph<NodeType, ArcType>& graph);
+
+	//Same path format as Graph::UCS
+	ArcType query(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+
+	//Index based query with caller owned contexts, safe to run on many threads at once
+	ArcType query(SearchContext<ArcType>& forward, SearchContext<ArcType>& backward, int start, int target, std::vector<int>& path) const;
+
+private:
+	static void addEdge(std::vector<Edge>& edges, int node, ArcType weight, int middle);
+	static void removeEdge(std::vector<Edge>& edges, int node);
+
+	void witnessSearch(EdgeLists const & out, SearchContext<ArcType>& ctx, int source, int skip, ArcType limit) const;
+	int findShortcuts(EdgeLists const & out, EdgeLists const & in, SearchContext<ArcType>& ctx, int node, std::vector<Edge>* pShortcuts, std::vector<int>* pFrom) const;
+
+	static void flatten(EdgeLists const & lists, GraphCSR<ArcType>& csr, std::vector<int>& middles);
+	static int findMiddle(GraphCSR<ArcType> const & csr, std::vector<int> const & middles, int node, int target);
+	void unpack(int from, int to, int middle, std::vector<int>& path) const;
+};
+
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::clear()
+{
+	m_pNodes = 0;
+	m_nodes = 0;
+	m_shortcuts = 0;
+	m_rank.clear();
+	m_up.clear();
+	m_upMiddle.clear();
+	m_down.clear();
+	m_downMiddle.clear();
+}
+
+//Adds an arc, or lowers the one already there
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::addEdge(std::vector<Edge>& edges, int node, ArcType weight, int middle)
+{
+	for (int e = 0, c = (int)edges.size(); e < c; ++e)
+	{
+		if (edges[e].node == node)
+		{
+			if (weight < edges[e].weight)
+			{
+				edges[e].weight = weight;
+				edges[e].middle = middle;
+			}
+			return;
+		}
+	}
+
+	Edge edge = { node, weight, middle };
+	edges.push_back(edge);
+}
+
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::removeEdge(std::vector<Edge>& edges, int node)
+{
+	for (int e = 0, c = (int)edges.size(); e < c; ++e)
+	{
+		if (edges[e].node == node)
+		{
+			edges[e] = edges.back();
+			edges.pop_back();
+			return;
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           witnessSearch
+//  Description:    UCS from source through the remaining graph that
+//                  never passes through skip. Stops once the open
+//                  list passes limit or enough nodes are settled, so
+//                  the G left in the context is only an upper bound.
+//  Arguments:      The first parameter is the remaining graph
+//                  The second is the context to search with
+//                  The third is the source index
+//                  The fourth is the node being contracted
+//                  The fifth is the largest cost worth searching to.
+//  Return Value:   None, results are left in the context.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::witnessSearch(EdgeLists const & out, SearchContext<ArcType>& ctx, int source, int skip, ArcType limit) const
+{
+	ctx.reset();
+	ctx.setG(source, 0);
+	ctx.setMarked(source, true);
+
+	IndexedHeap<float>& open = ctx.open();
+	open.push(source, 0);
+
+	int settled = 0;
+	while (!open.empty() && open.topKey() <= limit && settled++ < m_witnessLimit)
+	{
+		int top = open.pop();
+
+		for (int e = 0, c = (int)out[top].size(); e < c; ++e)
+		{
+			int child = out[top][e].node;
+			if (child == skip || ctx.closed(child))
+				continue;
+
+			ArcType gn = ctx.g(top) + out[top][e].weight;
+			if (gn < ctx.g(child))
+			{
+				ctx.setG(child, gn);
+				open.pushOrDecrease(child, gn);
+				ctx.setMarked(child, true);
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           findShortcuts
+//  Description:    Works out which shortcuts contracting a node would
+//                  need. A route in -> node -> out needs one unless a
+//                  witness search finds another route no longer.
+//  Arguments:      The first two parameters are the remaining graph
+//                  The third is a context for the witness searches
+//                  The fourth is the node to contract
+//                  The last two receive the shortcuts as (to, weight,
+//                  node) and their sources, both may be null.
+//  Return Value:   Number of shortcuts needed.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int ContractionHierarchy<NodeType, ArcType>::findShortcuts(EdgeLists const & out, EdgeLists const & in, SearchContext<ArcType>& ctx, int node, std::vector<Edge>* pShortcuts, std::vector<int>* pFrom) const
+{
+	int count = 0;
+	std::vector<Edge> const & outs = out[node];
+
+	for (int i = 0, ic = (int)in[node].size(); i < ic; ++i)
+	{
+		int from = in[node][i].node;
+		ArcType toNode = in[node][i].weight;
+
+		//Longest route through node worth finding a witness for
+		ArcType limit = 0;
+		bool any = false;
+		for (int o = 0, oc = (int)outs.size(); o < oc; ++o)
+		{
+			if (outs[o].node != from && toNode + outs[o].weight > limit)
+			{
+				limit = toNode + outs[o].weight;
+				any = true;
+			}
+		}
+
+		if (!any)
+			continue;
+
+		witnessSearch(out, ctx, from, node, limit);
+
+		for (int o = 0, oc = (int)outs.size(); o < oc; ++o)
+		{
+			int to = outs[o].node;
+			ArcType through = toNode + outs[o].weight;
+
+			if (to == from || ctx.g(to) <= through)
+				continue;
+
+			++count;
+			if (pShortcuts)
+			{
+				Edge shortcut = { to, through, node };
+				pShortcuts->push_back(shortcut);
+				pFrom->push_back(from);
+			}
+		}
+	}
+
+	return count;
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Orders the nodes by edge difference (shortcuts
+//                  added minus arcs removed, plus neighbours already
+//                  contracted to spread the order out) and contracts
+//                  them in that order. Priorities go stale as the
+//                  graph shrinks, so each one is worked out again
+//                  when it reaches the top of the queue and put back
+//                  if it's no longer the smallest.
+//  Arguments:      The graph to build from.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::build(Graph<NodeType, ArcType>& graph)
+{
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
+
+	clear();
+
+	GraphCSR<ArcType> const & csr = graph.csr();
+	m_pNodes = graph.nodeArray();
+	m_nodes = csr.nodeCount();
+
+	//Working graph both ways round, parallel arcs merged and loops dropped
+	EdgeLists out(m_nodes);
+	EdgeLists in(m_nodes);
+	for (int n = 0; n < m_nodes; ++n)
+	{
+		for (int arc = csr.begin(n), endArc = csr.end(n); arc != endArc; ++arc)
+		{
+			int to = csr.target(arc);
+			if (to == n)
+				continue;
+
+			addEdge(out[n], to, csr.weight(arc), -1);
+			addEdge(in[to], n, csr.weight(arc), -1);
+		}
+	}
+
+	//Final arcs of each node, taken as it's contracted
+	EdgeLists upLists(m_nodes);
+	EdgeLists downLists(m_nodes);
+
+	SearchContext<ArcType> ctx(m_nodes);
+	std::vector<int> contractedNeighbours(m_nodes, 0);
+	std::vector<Edge> shortcuts;
+	std::vector<int> shortcutFrom;
+
+	//Edge difference
+	auto priority = [&](int node) -> float
+	{
+		int added = findShortcuts(out, in, ctx, node, 0, 0);
+		return (float)(added - (int)out[node].size() - (int)in[node].size() + contractedNeighbours[node]);
+	};
+
+	IndexedHeap<float> queue;
+	queue.resize(m_nodes);
+	for (int n = 0; n < m_nodes; ++n)
+		queue.push(n, priority(n));
+
+	m_rank.assign(m_nodes, -1);
+	int order = 0;
+
+	while (!queue.empty())
+	{
+		int node = queue.pop();
+
+		//Lazy update, put it back if it's no longer the cheapest
+		float current = priority(node);
+		if (!queue.empty() && current > queue.topKey())
+		{
+			queue.push(node, current);
+			continue;
+		}
+
+		m_rank[node] = order++;
+
+		//Everything still attached is ranked higher
+		upLists[node] = out[node];
+		downLists[node] = in[node];
+
+		shortcuts.clear();
+		shortcutFrom.clear();
+		findShortcuts(out, in, ctx, node, &shortcuts, &shortcutFrom);
+
+		//Take the node out of the working graph
+		for (int e = 0, c = (int)out[node].size(); e < c; ++e)
+		{
+			removeEdge(in[out[node][e].node], node);
+			++contractedNeighbours[out[node][e].node];
+		}
+		for (int e = 0, c = (int)in[node].size(); e < c; ++e)
+		{
+			removeEdge(out[in[node][e].node], node);
+			++contractedNeighbours[in[node][e].node];
+		}
+		out[node].clear();
+		in[node].clear();
+
+		for (int s = 0, c = (int)shortcuts.size(); s < c; ++s)
+		{
+			addEdge(out[shortcutFrom[s]], shortcuts[s].node, shortcuts[s].weight, node);
+			addEdge(in[shortcuts[s].node], shortcutFrom[s], shortcuts[s].weight, node);
+		}
+		m_shortcuts += (int)shortcuts.size();
+	}
+
+	flatten(upLists, m_up, m_upMiddle);
+	flatten(downLists, m_down, m_downMiddle);
+
+	m_forward.resize(m_nodes);
+	m_backward.resize(m_nodes);
+
+	//Stop timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
+
+	if (m_verbosity >= 1)
+		std::cout << "Contraction hierarchy built in " << elapsed_seconds.count() << "s, " << m_shortcuts << " shortcuts" << std::endl;
+}
+
+//Packs per node arc lists into a CSR with a parallel middle array
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::flatten(EdgeLists const & lists, GraphCSR<ArcType>& csr, std::vector<int>& middles)
+{
+	int nodes = (int)lists.size();
+	std::vector<int> offsets(nodes + 1, 0);
+	for (int n = 0; n < nodes; ++n)
+		offsets[n + 1] = offsets[n] + (int)lists[n].size();
+
+	std::vector<int> targets(offsets[nodes]);
+	std::vector<ArcType> weights(offsets[nodes]);
+	middles.resize(offsets[nodes]);
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		for (int e = 0, c = (int)lists[n].size(); e < c; ++e)
+		{
+			targets[offsets[n] + e] = lists[n][e].node;
+			weights[offsets[n] + e] = lists[n][e].weight;
+			middles[offsets[n] + e] = lists[n][e].middle;
+		}
+	}
+
+	csr.assign(offsets, targets, weights);
+}
+
+//Middle node of the arc at node going to target
+template<class NodeType, class ArcType>
+int ContractionHierarchy<NodeType, ArcType>::findMiddle(GraphCSR<ArcType> const & csr, std::vector<int> const & middles, int node, int target)
+{
+	for (int arc = csr.begin(node), endArc = csr.end(node); arc != endArc; ++arc)
+	{
+		if (csr.target(arc) == target)
+			return middles[arc];
+	}
+
+	return -1;
+}
+
+// ----------------------------------------------------------------
+//  Name:           unpack
+//  Description:    Expands an arc back into the original arcs it
+//                  stands for. The middle node of a shortcut was
+//                  contracted before both ends, so from -> middle is
+//                  in the downward graph at middle and middle -> to
+//                  is in the upward graph at middle.
+//  Arguments:      The first two parameters are the arc's ends
+//                  The third is its middle node, -1 for a real arc
+//                  The fourth is the path to add to, everything after
+//                  from up to and including to is added.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void ContractionHierarchy<NodeType, ArcType>::unpack(int from, int to, int middle, std::vector<int>& path) const
+{
+	if (middle == -1)
+	{
+		path.push_back(to);
+		return;
+	}
+
+	unpack(from, middle, findMiddle(m_down, m_downMiddle, middle, from), path);
+	unpack(middle, to, findMiddle(m_up, m_upMiddle, middle, to), path);
+}
+
+// ----------------------------------------------------------------
+//  Name:           query
+//  Description:    Bidirectional UCS, forwards over the upward graph
+//                  from the start and backwards over the downward
+//                  graph from the target, alternating on the lower
+//                  key. Each side stops once its key can't beat the
+//                  best meeting found, then the route through the
+//                  meeting node is unpacked.
+//  Arguments:      The first two parameters are the contexts for each
+//                  side, resized as needed
+//                  The next two are the start and target indices
+//                  The last receives the node indices start first, it
+//                  is empty if the target can't be reached.
+//                  The forward context's budget applies to both sides,
+//                  how the query ended is left in its status. There
+//                  are no partial paths, the meeting node is on the
+//                  hierarchy rather than the route.
+//  Return Value:   Cost of the path, maxG if there isn't one or a
+//                  limit stopped the query.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+ArcType ContractionHierarchy<NodeType, ArcType>::query(SearchContext<ArcType>& forward, SearchContext<ArcType>& backward, int start, int target, std::vector<int>& path) const
+{
+	path.clear();
+
+	if (forward.size() < m_nodes)
+		forward.resize(m_nodes);
+	if (backward.size() < m_nodes)
+		backward.resize(m_nodes);
+
+	forward.reset();
+	backward.reset();
+
+	forward.setG(start, 0);
+	forward.setMarked(start, true);
+	forward.open().push(start, 0);
+	backward.setG(target, 0);
+	backward.setMarked(target, true);
+	backward.open().push(target, 0);
+
+	ArcType best = forward.maxG();
+	int meet = -1;
+
+	//Limits are only checked if there are any
+	SearchBudget const & budget = forward.budget();
+	bool limited = budget.limited();
+	SearchStatus status = Complete;
+	int expansions = 0;
+
+	for (;;)
+	{
+		bool forwardDone = forward.open().empty() || forward.open().topKey() >= best;
+		bool backwardDone = backward.open().empty() || backward.open().topKey() >= best;
+
+		if (forwardDone && backwardDone)
+			break;
+
+		//Expand whichever side has the lower key
+		bool forwards = backwardDone || (!forwardDone && forward.open().topKey() <= backward.open().topKey());
+		SearchContext<ArcType>& ctx = forwards ? forward : backward;
+		SearchContext<ArcType>& other = forwards ? backward : forward;
+		GraphCSR<ArcType> const & adj = forwards ? m_up : m_down;
+
+		//Keys are just g, so any route not found yet costs at least this much
+		if (limited)
+		{
+			status = budget.check(expansions++, (float)ctx.g(ctx.open().top()));
+			if (status != Complete)
+				break;
+		}
+
+		int top = ctx.open().pop();
+
+		//Both sides have reached it, so there's a route through it
+		if (other.marked(top) && ctx.g(top) + other.g(top) < best)
+		{
+			best = ctx.g(top) + other.g(top);
+			meet = top;
+		}
+
+		for (int arc = adj.begin(top), endArc = adj.end(top); arc != endArc; ++arc)
+		{
+			int child = adj.target(arc);
+			if (ctx.closed(child))
+				continue;
+
+			ArcType gn = ctx.g(top) + adj.weight(arc);
+			if (gn < ctx.g(child))
+			{
+				ctx.setG(child, gn);
+				ctx.setPrev(child, top);
+				ctx.open().pushOrDecrease(child, gn);
+				ctx.setMarked(child, true);
+			}
+		}
+	}
+
+	if (status == Complete && meet == -1)
+		status = Unreachable;
+
+	//Met, but by a route dearer than allowed
+	else if (status == Complete && budget.costLimited() && (float)best > budget.maxCost)
+		status = CostLimit;
+
+	forward.setStatus(status, -1);
+	if (status != Complete)
+		return forward.maxG();
+
+	//Start up to the meeting node, arcs from the upward graph
+	std::vector<int> climb;
+	for (int node = meet; node != -1; node = forward.prev(node))
+		climb.push_back(node);
+	std::reverse(climb.begin(), climb.end());
+
+	path.push_back(start);
+	for (int i = 1, c = (int)climb.size(); i < c; ++i)
+		unpack(climb[i - 1], climb[i], findMiddle(m_up, m_upMiddle, climb[i - 1], climb[i]), path);
+
+	//Meeting node down to the target, arcs from the downward graph
+	for (int node = meet; backward.prev(node) != -1; node = backward.prev(node))
+	{
+		int next = backward.prev(node);
+		unpack(node, next, findMiddle(m_down, m_downMiddle, next, node), path);
+	}
+
+	return best;
+}
+
+// ----------------------------------------------------------------
+//  Name:           query
+//  Description:    Node based query using the hierarchy's own
+//                  contexts, a drop in for Graph::UCS. Like UCS the
+//                  path is just the target if it can't be reached,
+//                  and empty if a limit stopped it, see setSearchBudget.
+//  Arguments:      The first two parameters are the start and target
+//                  The third is the path to fill.
+//  Return Value:   Cost of the path, maxG if there isn't one.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+ArcType ContractionHierarchy<NodeType, ArcType>::query(Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	std::vector<int> indices;
+	ArcType cost = query(m_forward, m_backward, pStart->index(), pTarget->index(), indices);
+
+	path.clear();
+	if (m_forward.status() > Unreachable)
+		return cost;
+
+	if (indices.empty())
+	{
+		path.push_back(pTarget);
+		return cost;
+	}
+
+	for (int i = 0, c = (int)indices.size(); i < c; ++i)
+		path.push_back(m_pNodes[indices[i]]);
+
+	return cost;
+}
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef DSTARLITE_H
+#define DSTARLITE_H
+
+#include <vector>
+
+#include "Graph.hpp"
+
+//No estimate between two nodes, D* Lite then repairs like a backward Dijkstra
+struct ZeroPairHeuristic {
+	float operator()(int, int) const { return 0; }
+};
+
+// ----------------------------------------------------------------
+//  Name:           DStarLite
+//  Description:    Incremental planner (D* Lite, Koenig and Likhachev)
+//                  for an agent moving towards a fixed goal while the
+//                  graph changes under it. It searches backward from
+//                  the goal and keeps g and rhs for every node between
+//                  plans, so after arcs are added, removed or
+//                  reweighted only the nodes whose costs actually
+//                  changed are looked at again. The changed arcs are
+//                  read from the graph's journal (Graph::changesSince).
+//
+//                  Each node has g, its settled cost to the goal, and
+//                  rhs, the best cost through its successors' g. A
+//                  node whose two differ is queued on
+//                      [min(g, rhs) + h(start, node) + km, min(g, rhs)]
+//                  and km grows by h(old start, new start) as the agent
+//                  moves, so keys already queued never need redoing.
+//
+//                  A SearchBudget can cap each plan(). The queue is
+//                  kept between calls, so the next plan() carries on
+//                  where a limit stopped the last one. maxCost is
+//                  checked against the popped node's cost to the goal.
+//  Arguments:      The heuristic gives the estimated cost between two
+//                  nodes, h(a, b), and must be consistent.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType, class Heuristic = ZeroPairHeuristic>
+class DStarLite {
+private:
+	struct Key {
+		float first;
+		float second;
+
+		bool operator<(Key const & other) const { return first < other.first || (first == other.first && second < other.second); }
+	};
+
+	Graph<NodeType, ArcType>* m_pGraph;
+	Heuristic m_heuristic;
+
+	std::vector<ArcType> m_g;
+	std::vector<ArcType> m_rhs;
+	IndexedHeap<Key> m_open;
+
+	int m_start; //Where the agent is now
+	int m_last; //Where it was when km was last moved
+	int m_goal;
+	float m_km; //Sum of h between every start the agent planned from
+	unsigned m_version; //Graph version the costs are good for, see Graph::changesSince
+	bool m_fresh; //Nothing planned since reset()
+	int m_expanded; //Nodes popped by the last plan()
+	SearchBudget m_budget; //Limits on each plan()
+	SearchStatus m_status; //How the last plan() ended
+
+	ArcType m_maxG; //Cost of a node that can't reach the goal
+
+	std::vector<std::pair<int, int>> m_changes; //Scratch for the journal
+
+	Key key(int node) const;
+	ArcType bestSuccessor(int node, GraphCSR<ArcType> const & forward) const;
+	void updateNode(int node);
+	void grow();
+	void restart();
+
+public:
+	explicit DStarLite(Graph<NodeType, ArcType>& graph, Heuristic heuristic = Heuristic());
+
+	//Start over towards a new goal
+	void reset(int start, int goal);
+
+	//The agent moved, plan() picks the route up from here
+	void moveTo(int start);
+
+	//Catches up with the graph's changes and settles the start
+	bool plan();
+	void setBudget(SearchBudget const & budget) { m_budget = budget; }
+
+	// Accessors
+	int start() const { return m_start; }
+	int goal() const { return m_goal; }
+	ArcType cost() const { return m_g[m_start]; }
+	bool reachable() const { return m_g[m_start] < m_maxG; }
+	int expanded() const { return m_expanded; }
+	SearchStatus status() const { return m_status; }
+	ArcType g(int node) const { return node < (int)m_g.size() ? m_g[node] : m_maxG; }
+
+	//Start to goal by cheapest next step, just the start if there's no route or a limit stopped plan()
+	void getPath(std::vector<int>& path);
+};
+
+template<class NodeType, class ArcType, class Heuristic>
+DStarLite<NodeType, ArcType, Heuristic>::DStarLite(Graph<NodeType, ArcType>& graph, Heuristic heuristic) :
+	m_pGraph(&graph), m_heuristic(heuristic), m_start(-1), m_last(-1), m_goal(-1), m_km(0), m_version(0), m_fresh(true), m_expanded(0), m_status(Complete),
+	m_maxG(SearchContext<ArcType>().maxG())
+{
+}
+
+template<class NodeType, class ArcType, class Heuristic>
+typename DStarLite<NodeType, ArcType, Heuristic>::Key DStarLite<NodeType, ArcType, Heuristic>::key(int node) const
+{
+	ArcType low = m_g[node] < m_rhs[node] ? m_g[node] : m_rhs[node];
+
+	Key k = { (float)low + m_heuristic(m_start, node) + m_km, (float)low };
+	return k;
+}
+
+//Lowest arc weight plus g over a node's successors, max if none reach the goal
+template<class NodeType, class ArcType, class Heuristic>
+ArcType DStarLite<NodeType, ArcType, Heuristic>::bestSuccessor(int node, GraphCSR<ArcType> const & forward) const
+{
+	ArcType best = m_maxG;
+
+	for (int arc = forward.begin(node), endArc = forward.end(node); arc != endArc; ++arc)
+	{
+		//Self loops are arcs removed since the last compact, see Graph::patchCsr
+		int child = forward.target(arc);
+		if (child == node)
+			continue;
+
+		ArcType g = m_g[child];
+		if (g >= m_maxG)
+			continue;
+
+		ArcType cost = forward.weight(arc) + g;
+		if (cost < best)
+			best = cost;
+	}
+
+	return best;
+}
+
+//Queues a node whose g and rhs differ with its current key, unqueues it if they agree
+template<class NodeType, class ArcType, class Heuristic>
+void DStarLite<NodeType, ArcType, Heuristic>::updateNode(int node)
+{
+	bool queued = m_open.contains(node);
+
+	if (m_g[node] != m_rhs[node])
+	{
+		if (queued)
+			m_open.update(node, key(node));
+		else m_open.push(node, key(node));
+	}
+	else if (queued)
+		m_open.remove(node);
+}
+
+//New nodes start out unable to reach the goal
+template<class NodeType, class ArcType, class Heuristic>
+void DStarLite<NodeType, ArcType, Heuristic>::grow()
+{
+	int count = m_pGraph->slotCount();
+	if (count <= (int)m_g.size())
+		return;
+
+	m_g.resize(count, m_maxG);
+	m_rhs.resize(count, m_maxG);
+
+	//The heap's slots are per node, so it's rebuilt at the new size
+	std::vector<int> queued;
+	while (!m_open.empty())
+		queued.push_back(m_open.pop());
+
+	m_open.resize(count);
+	for (size_t i = 0; i < queued.size(); ++i)
+		m_open.push(queued[i], key(queued[i]));
+}
+
+//Forgets every cost, only the goal is known
+template<class NodeType, class ArcType, class Heuristic>
+void DStarLite<NodeType, ArcType, Heuristic>::restart()
+{
+	int count = m_pGraph->slotCount();
+
+	m_g.assign(count, m_maxG);
+	m_rhs.assign(count, m_maxG);
+	m_open.resize(count);
+	m_km = 0;
+	m_last = m_start;
+
+	m_rhs[m_goal] = 0;
+	m_open.push(m_goal, key(m_goal));
+}
+
+template<class NodeType, class ArcType, class Heuristic>
+void DStarLite<NodeType, ArcType, Heuristic>::reset(int start, int goal)
+{
+	m_start = start;
+	m_goal = goal;
+	m_fresh = true;
+}
+
+template<class NodeType, class ArcType, class Heuristic>
+void DStarLite<NodeType, ArcType, Heuristic>::moveTo(int start)
+{
+	m_start = start;
+}
+
+// ----------------------------------------------------------------
+//  Name:           plan
+//  Description:    Brings the costs up to date. The first call after
+//                  reset(), or after the graph's journal has moved on
+//                  too far, plans from scratch. Later calls fold in
+//                  the start having moved (km) and every changed arc's
+//                  source, then settle nodes until the start is
+//                  consistent and nothing queued could improve it.
+//  Arguments:      None.
+//  Return Value:   True if the goal can be reached from the start.
+//                  False if it can't or a limit stopped the plan,
+//                  status() tells which.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType, class Heuristic>
+bool DStarLite<NodeType, ArcType, Heuristic>::plan()
+{
+	m_expanded = 0;
+	m_status = Unreachable;
+	if (!m_pGraph->exists(m_start) || !m_pGraph->exists(m_goal))
+		return false;
+
+	m_changes.clear();
+	if (m_fresh || !m_pGraph->changesSince(m_version, m_changes))
+	{
+		restart();
+		m_changes.clear();
+		m_fresh = false;
+	}
+	m_version = m_pGraph->version();
+
+	GraphCSR<ArcType> const & forward = m_pGraph->csr();
+	GraphCSR<ArcType> const & reverse = m_pGraph->reverseCsr();
+	grow();
+
+	//Keys queued before the move are low by at most h(last, start)
+	if (m_last != m_start)
+	{
+		m_km += m_heuristic(m_last, m_start);
+		m_last = m_start;
+	}
+
+	//Only the source of a changed arc can have a different rhs
+	for (size_t i = 0; i < m_changes.size(); ++i)
+	{
+		int node = m_changes[i].first;
+		if (node == m_goal || node >= (int)m_g.size())
+			continue;
+
+		m_rhs[node] = m_pGraph->exists(node) ? bestSuccessor(node, forward) : m_maxG;
+		updateNode(node);
+	}
+
+	//Limits are only checked if there are any
+	bool limited = m_budget.limited();
+
+	while (!m_open.empty() && (m_open.topKey() < key(m_start) || m_rhs[m_start] != m_g[m_start]))
+	{
+		int node = m_open.top();
+		Key old = m_open.topKey();
+		Key now = key(node);
+
+		//Stop at the first limit reached, the queue is left for the next plan()
+		if (limited)
+		{
+			m_status = m_budget.check(m_expanded, now.second);
+			if (m_status != Complete)
+				return false;
+		}
+		++m_expanded;
+
+		//Queued before km moved on, requeue with the right key
+		if (old < now)
+		{
+			m_open.update(node, now);
+			continue;
+		}
+
+		if (m_g[node] > m_rhs[node])
+		{
+			//Cheaper than before, settle it and offer it to its predecessors
+			m_g[node] = m_rhs[node];
+			m_open.remove(node);
+
+			for (int arc = reverse.begin(node), endArc = reverse.end(node); arc != endArc; ++arc)
+			{
+				int pred = reverse.target(arc);
+				if (pred == node)
+					continue;
+
+				ArcType cost = reverse.weight(arc) + m_g[node];
+
+				if (pred != m_goal && cost < m_rhs[pred])
+				{
+					m_rhs[pred] = cost;
+					updateNode(pred);
+				}
+			}
+		}
+		else
+		{
+			//Dearer than before, forget it and let it and its predecessors look again
+			ArcType oldG = m_g[node];
+			m_g[node] = m_maxG;
+
+			if (node != m_goal)
+				m_rhs[node] = bestSuccessor(node, forward);
+			updateNode(node);
+
+			for (int arc = reverse.begin(node), endArc = reverse.end(node); arc != endArc; ++arc)
+			{
+				int pred = reverse.target(arc);
+				if (pred == node)
+					continue;
+
+				//Only predecessors whose best route went through this node
+				if (pred != m_goal && oldG < m_maxG && m_rhs[pred] == reverse.weight(arc) + oldG)
+				{
+					m_rhs[pred] = bestSuccessor(pred, forward);
+					updateNode(pred);
+				}
+			}
+		}
+	}
+
+	m_status = reachable() ? Complete : Unreachable;
+	return reachable();
+}
+
+template<class NodeType, class ArcType, class Heuristic>
+void DStarLite<NodeType, ArcType, Heuristic>::getPath(std::vector<int>& path)
+{
+	path.clear();
+	path.push_back(m_start);
+
+	//Costs are only part way repaired after a limit
+	if (!reachable() || m_status > Unreachable)
+		return;
+
+	GraphCSR<ArcType> const & forward = m_pGraph->csr();
+	int node = m_start;
+
+	//Every step lowers g, the count is only a guard
+	for (int steps = 0; node != m_goal && steps < (int)m_g.size(); ++steps)
+	{
+		int next = -1;
+		ArcType best = m_maxG;
+
+		for (int arc = forward.begin(node), endArc = forward.end(node); arc != endArc; ++arc)
+		{
+			int child = forward.target(arc);
+			if (child == node || m_g[child] >= m_maxG)
+				continue;
+
+			ArcType cost = forward.weight(arc) + m_g[child];
+			if (cost < best)
+			{
+				best = cost;
+				next = child;
+			}
+		}
+
+		if (next == -1)
+			break;
+
+		path.push_back(next);
+		node = next;
+	}
+}
+
+#endif
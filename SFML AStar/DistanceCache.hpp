@@ -0,0 +1,139 @@
+#ifndef DISTANCECACHE_H
+#define DISTANCECACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// ----------------------------------------------------------------
+//  Name:           DistanceCache
+//  Description:    Least recently used cache of one distance array per
+//                  target, within a budget of bytes. Every array is
+//                  tagged with the graph version it was worked out for
+//                  (Graph::version), and asking with any other version
+//                  empties the cache, so arcs changing can't leave
+//                  stale distances behind.
+// ----------------------------------------------------------------
+template<class ArcType>
+class DistanceCache {
+private:
+	struct Entry {
+		std::vector<ArcType> distances;
+		typename std::list<int>::iterator order; //Place in m_order
+	};
+
+	std::unordered_map<int, Entry> m_entries; //By target
+	std::list<int> m_order; //Targets, most recently used first
+	std::vector<ArcType> m_overflow; //For an array too big to keep at all
+
+	size_t m_budget; //Bytes the arrays may take
+	size_t m_used; //Bytes they take now
+	unsigned m_version; //Graph version every entry is for
+
+	int m_hits;
+	int m_misses;
+
+	static size_t bytes(size_t count) { return count * sizeof(ArcType); }
+	void evict();
+
+public:
+	explicit DistanceCache(size_t budget = 32 << 20) : m_budget(budget), m_used(0), m_version(0), m_hits(0), m_misses(0) {}
+
+	//Cached distances for a target at a version, 0 if there are none
+	std::vector<ArcType> const * find(int target, unsigned version);
+
+	//Array of count entries to fill in for a target, kept if the budget allows
+	std::vector<ArcType>& insert(int target, unsigned version, int count);
+
+	void setBudget(size_t budget) { m_budget = budget; evict(); }
+	void clear();
+
+	// Accessors
+	size_t budget() const { return m_budget; }
+	size_t used() const { return m_used; }
+	int size() const { return (int)m_entries.size(); }
+	int hits() const { return m_hits; }
+	int misses() const { return m_misses; }
+};
+
+template<class ArcType>
+std::vector<ArcType> const * DistanceCache<ArcType>::find(int target, unsigned version)
+{
+	if (version != m_version)
+	{
+		clear();
+		m_version = version;
+	}
+
+	typename std::unordered_map<int, Entry>::iterator found = m_entries.find(target);
+	if (found == m_entries.end())
+	{
+		++m_misses;
+		return 0;
+	}
+
+	//Move to the front, the list nodes themselves stay put
+	m_order.splice(m_order.begin(), m_order, found->second.order);
+	++m_hits;
+
+	return &found->second.distances;
+}
+
+template<class ArcType>
+std::vector<ArcType>& DistanceCache<ArcType>::insert(int target, unsigned version, int count)
+{
+	if (version != m_version)
+	{
+		clear();
+		m_version = version;
+	}
+
+	//Too big to keep, handed out for this query only
+	if (bytes(count) > m_budget)
+	{
+		m_overflow.resize(count);
+		return m_overflow;
+	}
+
+	typename std::unordered_map<int, Entry>::iterator found = m_entries.find(target);
+	if (found != m_entries.end())
+	{
+		m_used -= bytes(found->second.distances.size());
+		m_order.erase(found->second.order);
+		m_entries.erase(found);
+	}
+
+	//Room first, so the new array isn't the one evicted
+	m_used += bytes(count);
+	evict();
+
+	m_order.push_front(target);
+	Entry& entry = m_entries[target];
+	entry.distances.resize(count);
+	entry.order = m_order.begin();
+
+	return entry.distances;
+}
+
+//Drops the least recently used arrays until the budget is met
+template<class ArcType>
+void DistanceCache<ArcType>::evict()
+{
+	while (m_used > m_budget && !m_order.empty())
+	{
+		typename std::unordered_map<int, Entry>::iterator last = m_entries.find(m_order.back());
+		m_used -= bytes(last->second.distances.size());
+		m_entries.erase(last);
+		m_order.pop_back();
+	}
+}
+
+template<class ArcType>
+void DistanceCache<ArcType>::clear()
+{
+	m_entries.clear();
+	m_order.clear();
+	m_used = 0;
+}
+
+#endif
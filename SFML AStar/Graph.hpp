@@ -4,19 +4,25 @@
 #include <list>
 #include <queue>
 #include <sstream>
+#include <unordered_set>
 
 #include <time.h>
 
 #include <chrono>
 #include <ctime>
 
+#include "AnytimeSearch.hpp"
+#include "Arena.hpp"
+#include "DistanceCache.hpp"
+#include "GraphCSR.hpp"
+#include "GraphSearch.hpp"
+#include "Landmarks.hpp"
+#include "ParallelFor.hpp"
 
 using namespace std;
 
 template <class NodeType, class ArcType> class GraphArc;
 template <class NodeType, class ArcType> class GraphNode;
-typedef vector<pair<char, int>> HeurVec;
-typedef vector<pair<char, HeurVec>> HeurMap;
 
 template<class NodeType, class ArcType>
 class Graph {
@@ -24,52 +30,110 @@ private:
     typedef GraphArc<NodeType, ArcType> Arc;
     typedef GraphNode<NodeType, ArcType> Node;
 
-    Node** m_pNodes; //An array of all the nodes in the graph.
-    int m_maxNodes;
+    vector<Node*> m_pNodes; //Every node slot in the graph, indexed by node id, null if empty.
     int m_count;
+
+	//Node and arc storage, see Arena.hpp. Nodes come from slabs sized by
+	//the reserve hint, so a node never moves once added, arc list entries
+	//from slabs in the arena.
+	SlabPool m_nodePool;
+	Arena m_arena;
+	void destroyNode(int index);
+	void grow(int slots);
 	float m_heurMult; //Heuristic multiplier for A*
 
+	//Contiguous adjacency used by the searches, and the same turned around
+	GraphCSR<ArcType> m_csr;
+	GraphCSR<ArcType> m_reverse;
+	bool m_csrDirty; //Set whenever nodes or arcs change
+	int m_deadArcs; //Removed arcs still in the CSRs as self loops, see patchCsr
+	bool patchCsr(int from, int to, ArcType weight, bool remove);
+	void dropLandmarks();
+
+	//Node positions as flat arrays for the distance kernels, by node id,
+	//as of the last compact() or genMap()
+	vector<float> m_posX, m_posY;
+	void gatherPositions();
+
+	//Duplicate arc checks, see beginBulk and setArcIndex
+	bool m_bulk; //Arcs go in unchecked, endBulk removes repeats
+	bool m_indexArcs; //Keep m_arcIndex up to date
+	unordered_set<unsigned long long> m_arcIndex; //Every from, to pair, when m_indexArcs is set
+	static unsigned long long arcKey(int from, int to) { return (unsigned long long)(unsigned)from << 32 | (unsigned)to; }
+	bool hasArc(int from, int to);
+
+	//Change journal, see changesSince
+	unsigned m_version; //Bumped by every change to the arcs
+	unsigned m_journalStart; //Version before the first journal entry
+	vector<pair<int, int>> m_journal; //From, to of each arc changed, entry i took the version from m_journalStart + i
+	void journal(int from, int to);
+	void forgetJournal();
+
+	//Search state used by the node based searches and for drawing
+	SearchContext<ArcType> m_context;
+	SearchContext<ArcType> m_backContext; //Backward side of the bidirectional searches
+
 	//Output
 	int m_verbosity = 1; //Verbosity for output
 	stringstream gop; //Reusable stringstream for output
 	void gout(int verbosity); //Output function
 
 	//Map of heuristics for this graph
-	HeurMap m_map; //Map will be empty by default
-	float distanceBetween(const sf::Vector2f v1, const sf::Vector2f v2);
-	float mapLookup(Node* pStart, Node* pEnd);
+	//Lower triangle only, as the distances are symmetric: row i holds
+	//columns 0 to i and starts at i * (i + 1) / 2. Empty in lazy mode.
+	vector<float> m_map;
+	int m_mapSize; //Node slots when the map was made, 0 for no map
+	bool m_mapLazy; //Distances worked out on each lookup rather than stored
+	float mapLookup(int from, int to) const;
 
-	//Maximum H and G values
-	const int maxG = INT_MAX - 20000;
-	const int maxH = INT_MAX - 20000;
+	//Landmark (ALT) heuristic data, empty by default
+	LandmarkTable<ArcType> m_landmarks;
 
-	//Preparations
-	void clearMarks();
-	void clearPrevs();
-	void maxGs();
-	void maxHs();
+	//Costs out from recent A* targets, so a repeat target skips InitAStar's UCS
+	DistanceCache<ArcType> m_targetCache;
 
 public:           
     // Constructor and destructor functions
-    Graph( int size );
+    Graph( int size = 0 );
     ~Graph();
 
 	//Reset graph
 	void reset();
 
     // Accessors
-	Node** nodeArray() const { return m_pNodes; }
+	Node* const * nodeArray() const { return m_pNodes.data(); } //Moves if the graph grows
+	int slotCount() const { return (int)m_pNodes.size(); } //Highest node id + 1
+	bool exists(int index) const { return index >= 0 && index < slotCount() && m_pNodes[index] != 0; }
 	float heurMult() { return m_heurMult; }
 	int verbosity() { return verbosity; }
 	int count() { return m_count; }
-	bool hasMap() { return !m_map.empty(); }
+	bool hasMap() { return m_mapSize > 0; }
+	bool hasLandmarks() { return !m_landmarks.empty(); }
+	LandmarkTable<ArcType> const & landmarks() const { return m_landmarks; }
+	GraphCSR<ArcType> const & csr() { if (m_csrDirty) compact(); return m_csr; }
+	GraphCSR<ArcType> const & reverseCsr() { if (m_csrDirty) compact(); return m_reverse; }
+	int deadArcs() const { return m_deadArcs; }
+	float const * positionsX() { if (m_csrDirty) compact(); return m_posX.data(); }
+	float const * positionsY() { if (m_csrDirty) compact(); return m_posY.data(); }
+	PositionHeuristic positionHeuristic(int target, Distance distance = Distance()) { return PositionHeuristic(positionsX(), positionsY(), target, distance); }
+
+	//Search results held in the graph's own context
+	SearchContext<ArcType> & context() { return m_context; }
+	ArcType g(Node* pNode) const { return m_context.g(pNode->index()); }
+	float h(Node* pNode) const { return m_context.h(pNode->index()); }
+	bool marked(Node* pNode) const { return m_context.marked(pNode->index()); }
+	Node* getPrev(Node* pNode) const { int prev = m_context.prev(pNode->index()); return prev == -1 ? NULL : m_pNodes[prev]; }
+	SearchStatus searchStatus() const { return m_context.status(); }
 
 	// Manipulators
 	void setHeurMult(float HeurMult) { m_heurMult = HeurMult; }
 	void setVerbosity(int verbosity) { m_verbosity = verbosity; }
+	void setSearchBudget(SearchBudget const & budget) { m_context.setBudget(budget); } //For the node based searches, solveBatch and distanceMatrix
 
 	//Nodes
+	void reserve(int nodes);
     bool addNode( NodeType data, int index );
+	int addNode(NodeType data);
     void removeNode(int index);
 	void showNodes();
 
@@ -82,9 +146,40 @@ public:
 	bool addDualArc(int n1, int n2, ArcType weight);
 	void removeDualArc(int n1, int n2);
 
+	//Bulk arcs, every arc of a CSR built with GraphCSR::build
+	void addArcs(GraphCSR<ArcType> const & arcs);
+
+	//Between these addArc and addDualArc skip the duplicate check and the journal, endBulk removes repeats.
+	//The version moves once at each end rather than once per arc
+	void beginBulk() { m_bulk = true; forgetJournal(); }
+	void endBulk();
+
+	//Hashed from, to index so the duplicate check doesn't walk the arc list
+	void setArcIndex(bool on);
+
+	//Changes the weight of an existing arc, the way to do it once searches have run
+	bool setArcWeight(int from, int to, ArcType weight);
+
+	//Arcs changed since a version, for planners that repair rather than start again
+	unsigned version() const { return m_version; }
+	bool changesSince(unsigned version, vector<pair<int, int>>& arcs) const;
+
+	//Rebuild the CSR adjacency, call once loading finishes
+	void compact();
+
 	//Mapping
-	void genMap();
+	void genMap(bool lazy = false, int threads = 0);
 	void mapNodes(Node* pEnd);
+	void mapNodes(SearchContext<ArcType>& ctx, int target) const;
+
+	//Costs from a target to every node, cached by target until the arcs change
+	vector<ArcType> const & targetDistances(int target);
+	void setTargetCacheBudget(size_t bytes) { m_targetCache.setBudget(bytes); }
+	DistanceCache<ArcType> const & targetCache() const { return m_targetCache; }
+
+	//Landmarks
+	void genLandmarks(int count = 8);
+	void landmarkNodes(Node* pEnd);
 
 	//Graph exercises
     void depthFirst( Node* pNode, void (*pProcess)(Node*) );
@@ -94,35 +189,41 @@ public:
 	void InitAStar(Node* pTarget);
 	void AStar(Node* pStart, Node* pTarget, std::vector<Node*>& path);
 	void AStarPrecomp(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+	void AStarLandmark(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+	void AStarAnytime(Node* pStart, Node* pTarget, std::vector<Node*>& path, double seconds, float initialWeight = 2.5f, float step = 0.5f);
+	void BidirectionalUCS(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+	void BidirectionalAStar(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+
+	//Searches on a caller owned context, compact() the graph first
+	SearchStatus UCS(SearchContext<ArcType>& ctx, int start, int target) const;
+	template<class Trace>
+	SearchStatus UCS(SearchContext<ArcType>& ctx, int start, int target, Trace& trace) const;
+	void InitAStar(SearchContext<ArcType>& ctx, int target) const;
+	template<class Trace>
+	void InitAStar(SearchContext<ArcType>& ctx, int target, Trace& trace) const;
+	template<class Heuristic>
+	SearchStatus AStar(SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic) const;
+	template<class Heuristic, class Trace>
+	SearchStatus AStar(SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic, Trace& trace) const;
+	SearchStatus BidirectionalUCS(SearchContext<ArcType>& ctx, SearchContext<ArcType>& back, int start, int target) const;
+	template<class ToTarget, class FromStart>
+	SearchStatus BidirectionalAStar(SearchContext<ArcType>& ctx, SearchContext<ArcType>& back, int start, int target, ToTarget toTarget, FromStart fromStart) const;
+	void getPath(SearchContext<ArcType> const & ctx, int target, std::vector<int>& path) const;
+	void getPath(SearchContext<ArcType> const & ctx, int target, std::vector<Node*>& path) const;
+
+	//Batch queries, each path is pathNodes[pathOffsets[i], pathOffsets[i + 1])
+	void solveBatch(pair<int, int> const * queries, int count, vector<int>& pathNodes, vector<int>& pathOffsets, int threads = 0);
+	void solveBatch(vector<pair<int, int>> const & queries, vector<int>& pathNodes, vector<int>& pathOffsets, int threads = 0);
+
+	//Cost from every source to every target, row major, matrix[s * targets + t]
+	void distanceMatrix(vector<int> const & sources, vector<int> const & targets, vector<ArcType>& matrix, int threads = 0);
 };
 
 template<class NodeType, class ArcType>
-class NodeSearchCostComparer {
-public:
-	bool operator()(GraphNode<NodeType, ArcType> * n1, GraphNode<NodeType, ArcType> * n2) {
-		return n1->g() > n2->g();
-	}
-};
+Graph<NodeType, ArcType>::Graph( int size ) : m_count(0), m_nodePool(sizeof(Node), size > 0 ? size : 64), m_heurMult(0.9), m_csrDirty(true), m_deadArcs(0), m_bulk(false), m_indexArcs(false), m_version(0), m_journalStart(0), m_mapSize(0), m_mapLazy(false) {
+	// size is only a hint, the graph grows past it as nodes are added
+	reserve(size);
 
-template<class NodeType, class ArcType>
-class ANodeSearchCostComparer {
-public:
-	bool operator()(GraphNode<NodeType, ArcType> * n1, GraphNode<NodeType, ArcType> * n2) {
-		return n1->g() + n1->h() > n2->g() + n2->h();
-	}
-};
-
-template<class NodeType, class ArcType>
-Graph<NodeType, ArcType>::Graph( int size ) : m_maxNodes( size ), m_heurMult(0.9) {
-	int i;
-	m_pNodes = new Node * [m_maxNodes];
-	// go through every index and clear it to null (0)
-	for( i = 0; i < m_maxNodes; i++ ) {
-		m_pNodes[i] = 0;
-	}
-	
-	// set the node count to 0.
-	m_count = 0;
 	gop << "Constructing graph..." << endl;
 	gout(3);
 }
@@ -131,35 +232,78 @@ template<class NodeType, class ArcType>
 Graph<NodeType, ArcType>::~Graph() {
 
 	int index;
-	for( index = 0; index < m_maxNodes; index++ ) {
+	for( index = 0; index < slotCount(); index++ ) {
 		if( m_pNodes[index] != 0 ) {
-			delete m_pNodes[index];
+			destroyNode(index);
 		}
 	}
-	// Delete the actual array
-	delete m_pNodes;
+	// the pools free their slabs after this
 	gop << "Deconstructing Graph..." << endl;
 	gout(3);
 }
 
+//Nodes were placed in the pool, so they're destroyed and handed back by hand
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::destroyNode(int index)
+{
+	m_pNodes[index]->~Node();
+	m_nodePool.deallocate(m_pNodes[index]);
+}
+
+// ----------------------------------------------------------------
+//  Name:           reserve
+//  Description:    Makes room for at least nodes node slots without
+//                  reallocating, and for that many nodes in one slab.
+//                  Only a hint, adding past it still works.
+//  Arguments:      Number of node slots expected.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::reserve(int nodes)
+{
+	if (nodes <= slotCount())
+		return;
+
+	m_pNodes.reserve(nodes);
+	m_nodePool.reserve(nodes - m_count);
+}
+
+//Adds empty slots up to slots, vector growth keeps this amortised O(1) per node
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::grow(int slots)
+{
+	if (slots <= slotCount())
+		return;
+
+	m_pNodes.resize(slots, 0);
+	m_context.resize(slots);
+}
+
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::reset()
 {
-	clearMarks();
-	maxGs();
-	maxHs();
+	m_context.reset();
+	m_context.resetH();
+
+	gop << "Search state reset." << endl;
+	gout(2);
 }
 
 template<class NodeType, class ArcType>
 bool Graph<NodeType, ArcType>::addNode( NodeType data, int index ) {
    bool nodeNotPresent = false;
-   // find out if a node does not exist at that index.
+   if (index < 0)
+	   return false;
+
+   // make room for the index, then find out if a node does not exist there.
+   grow(index + 1);
    if ( m_pNodes[index] == 0) {
 		nodeNotPresent = true;
-		// create a new node, put the data in it, and unmark it.
-		m_pNodes[index] = new Node;
+		// create a new node in the pool and put the data in it.
+		m_pNodes[index] = new (m_nodePool.allocate()) Node(ArenaAllocator<Arc>(&m_arena));
 		m_pNodes[index]->setData(data);
-		m_pNodes[index]->setMarked(false);
+		m_pNodes[index]->setIndex(index);
+		m_csrDirty = true;
 
 		gop << "\t" << "Adding node: " << data << endl;
 		gout(3);
@@ -169,11 +313,20 @@ bool Graph<NodeType, ArcType>::addNode( NodeType data, int index ) {
     return nodeNotPresent;
 }
 
+//Adds a node in the next free id past every other node and returns that id
+template<class NodeType, class ArcType>
+int Graph<NodeType, ArcType>::addNode(NodeType data)
+{
+	int index = slotCount();
+	addNode(data, index);
+	return index;
+}
+
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::removeNode( int index ) {
 
     // Only proceed if node does exist.
-    if( m_pNodes[index] != 0 ) {
+    if( exists(index) ) {
 
 		// now find every arc that points to the node that
          // is being removed and remove it.
@@ -181,11 +334,12 @@ void Graph<NodeType, ArcType>::removeNode( int index ) {
 		Arc* arc;
 		
 		// loop through every node
-		for( node = 0; node < m_maxNodes; node++ ) {
+		for( node = 0; node < slotCount(); node++ ) {
+		     arc = 0;
 		     // if the node is valid...
 		     if( m_pNodes[node] != 0 ) {
 		         // see if the node has an arc pointing to the current node.
-		         arc = m_pNodes[node]->getArc( m_pNodes[index] );
+		         arc = hasArc( node, index ) ? m_pNodes[node]->getArc( m_pNodes[index] ) : 0;
 		     }
 		     // if it has an arc pointing to the current node, then
               // remove the arc.
@@ -196,11 +350,19 @@ void Graph<NodeType, ArcType>::removeNode( int index ) {
 		gop << "\t" << "Removing node: " << m_pNodes[index]->data() << endl;
 		gout(3);
 
+		// its own arcs go with it, so drop them from the index and journal them
+		typename Node::ArcList::const_iterator iter = m_pNodes[index]->arcList().begin();
+		for (; iter != m_pNodes[index]->arcList().end(); ++iter) {
+			m_arcIndex.erase(arcKey(index, (*iter).node()->index()));
+			journal(index, (*iter).node()->index());
+		}
+
 		// now that every arc pointing to the current node has been removed,
         // the node can be deleted.
-		delete m_pNodes[index];
+		destroyNode(index);
 		m_pNodes[index] = 0;
 		m_count--;
+		m_csrDirty = true;
 		
     }
 }
@@ -222,18 +384,24 @@ template<class NodeType, class ArcType>
 bool Graph<NodeType, ArcType>::addArc( int from, int to, ArcType weight ) {
      bool proceed = true; 
      // make sure both nodes exist.
-     if( m_pNodes[from] == 0 || m_pNodes[to] == 0 ) {
+     if( !exists(from) || !exists(to) ) {
          proceed = false;
      }
         
      // if an arc already exists we should not proceed
-     if( m_pNodes[from]->getArc( m_pNodes[to] ) != 0 ) {
+     else if( !m_bulk && hasArc( from, to ) ) {
          proceed = false;
      }
 
      if (proceed == true) {
         // add the arc to the "from" node.
         m_pNodes[from]->addArc( m_pNodes[to], weight );
+		m_csrDirty = true;
+		if (m_indexArcs && !m_bulk)
+			m_arcIndex.insert(arcKey(from, to));
+		//Bulk arcs aren't journaled, beginBulk and endBulk move the version instead
+		if (!m_bulk)
+			journal(from, to);
 
 		gop << "\t" << "Adding arc from " << m_pNodes[from]->data() << " to " << m_pNodes[to]->data() << " weight " << weight << endl;
 		gout(3);
@@ -247,13 +415,19 @@ void Graph<NodeType, ArcType>::removeArc( int from, int to ) {
      // Make sure that the node exists before trying to remove
      // an arc from it.
      bool nodeExists = true;
-     if( m_pNodes[from] == 0 || m_pNodes[to] == 0 ) {
+     if( !exists(from) || !exists(to) ) {
          nodeExists = false;
      }
 
      if (nodeExists == true) {
         // remove the arc.
         m_pNodes[from]->removeArc( m_pNodes[to] );
+		m_arcIndex.erase(arcKey(from, to));
+
+		//Left in the CSRs as a dead arc until too many pile up
+		if (m_deadArcs * 4 >= m_csr.arcCount() || !patchCsr(from, to, ArcType(), true))
+			m_csrDirty = true;
+		journal(from, to);
 
 		gop << "\t" << "Removing arc from " << m_pNodes[from]->data() << " to " << m_pNodes[to]->data() << endl;
 		gout(3);
@@ -264,12 +438,12 @@ template<class NodeType, class ArcType>
 bool Graph<NodeType, ArcType>::addDualArc(int n1, int n2, ArcType weight) {
 	bool proceed = true;
 	// make sure both nodes exist.
-	if (m_pNodes[n1] == 0 || m_pNodes[n2] == 0) {
+	if (!exists(n1) || !exists(n2)) {
 		proceed = false;
 	}
 
 	// if an arc already exists we should not proceed
-	if (m_pNodes[n1]->getArc(m_pNodes[n2]) != 0) {
+	else if (!m_bulk && hasArc(n1, n2)) {
 		proceed = false;
 	}
 
@@ -277,6 +451,15 @@ bool Graph<NodeType, ArcType>::addDualArc(int n1, int n2, ArcType weight) {
 		// add the arc to n1 and n2.
 		m_pNodes[n1]->addArc(m_pNodes[n2], weight);
 		m_pNodes[n2]->addArc(m_pNodes[n1], weight);
+		m_csrDirty = true;
+		if (m_indexArcs && !m_bulk) {
+			m_arcIndex.insert(arcKey(n1, n2));
+			m_arcIndex.insert(arcKey(n2, n1));
+		}
+		if (!m_bulk) {
+			journal(n1, n2);
+			journal(n2, n1);
+		}
 
 		gop << "\t" << "Adding dual arc between " << m_pNodes[n1]->data() << " and " << m_pNodes[n2]->data() << " weight " << weight << endl;
 		gout(3);
@@ -290,13 +473,23 @@ void Graph<NodeType, ArcType>::removeDualArc(int n1, int n2) {
 	// Make sure that the node exists before trying to remove
 	// an arc from it.
 	bool nodeExists = true;
-	if (m_pNodes[n1] == 0 || m_pNodes[n2] == 0) {
+	if (!exists(n1) || !exists(n2)) {
 		nodeExists = false;
 	}
 
 	if (nodeExists == true) {
-		// remove the arc.
+		// remove the arc both ways.
 		m_pNodes[n1]->removeArc(m_pNodes[n2]);
+		m_pNodes[n2]->removeArc(m_pNodes[n1]);
+		m_arcIndex.erase(arcKey(n1, n2));
+		m_arcIndex.erase(arcKey(n2, n1));
+
+		//Left in the CSRs as dead arcs, see removeArc
+		if (m_deadArcs * 4 >= m_csr.arcCount() || !patchCsr(n1, n2, ArcType(), true) || !patchCsr(n2, n1, ArcType(), true))
+			m_csrDirty = true;
+
+		journal(n1, n2);
+		journal(n2, n1);
 
 		gop << "\t" << "Removing dual arc between " << m_pNodes[n1]->data() << " to " << m_pNodes[n2]->data() << endl;
 		gout(3);
@@ -304,165 +497,420 @@ void Graph<NodeType, ArcType>::removeDualArc(int n1, int n2) {
 
 }
 
+// ----------------------------------------------------------------
+//  Name:           addArcs
+//  Description:    Adds every arc of a CSR in one pass. The CSR has
+//                  no repeated pairs, so a node that had no arcs
+//                  before skips the getArc check addArc does for each
+//                  arc. Arcs to or from missing nodes are skipped.
+//  Arguments:      The arcs to add, indexed by node id.
+//  Return Value:   None.
+// ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-// Dev-CPP doesn't like Arc* as the (typedef'd) return type?
-GraphArc<NodeType, ArcType>* Graph<NodeType, ArcType>::getArc( int from, int to ) {
-     Arc* pArc = 0;
-     // make sure the to and from nodes exist
-     if( m_pNodes[from] != 0 && m_pNodes[to] != 0 ) {
-         pArc = m_pNodes[from]->getArc( m_pNodes[to] );
-     }
-                
-     return pArc;
-}
-
-template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::clearMarks()
+void Graph<NodeType, ArcType>::addArcs(GraphCSR<ArcType> const & arcs)
 {
-	for (int index = 0; index < m_maxNodes; ++index) {
-		if (m_pNodes[index] != 0)
-		{
-			m_pNodes[index]->setMarked(false);
+	int added = 0;
+	for (int from = 0, nodes = arcs.nodeCount(); from < nodes; ++from)
+	{
+		if (!exists(from))
+			continue;
 
-			gop << m_pNodes[index]->data() << " unmarked." << endl;
-			gout(4);
+		bool check = !m_bulk && !m_pNodes[from]->arcList().empty();
+		for (int arc = arcs.begin(from), endArc = arcs.end(from); arc != endArc; ++arc)
+		{
+			int to = arcs.target(arc);
+			if (!exists(to) || (check && hasArc(from, to)))
+				continue;
+
+			m_pNodes[from]->addArc(m_pNodes[to], arcs.weight(arc));
+			if (m_indexArcs && !m_bulk)
+				m_arcIndex.insert(arcKey(from, to));
+			++added;
 		}
 	}
 
-	gop << "Unmarked all nodes" << endl;
+	m_csrDirty = true;
+	forgetJournal();
+
+	gop << "Added " << added << " arcs." << endl;
 	gout(2);
 }
 
+//Whether from already has an arc to to, from the index if there is one
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::clearPrevs()
+bool Graph<NodeType, ArcType>::hasArc(int from, int to)
 {
-	
-	for (int index = 0; index < m_maxNodes; ++index) {
-		if (m_pNodes[index] != 0)
-		{
-			m_pNodes[index]->setPrev(NULL);
+	if (m_indexArcs && !m_bulk)
+		return m_arcIndex.count(arcKey(from, to)) != 0;
 
-			gop << m_pNodes[index]->data() << " previous cleared." << endl;
-			gout(4);
-		}
+	return m_pNodes[from]->getArc(m_pNodes[to]) != 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           endBulk
+//  Description:    Ends a bulk build started with beginBulk. Arcs went
+//                  in without the duplicate check, so repeated pairs
+//                  are removed here in one pass over every arc list,
+//                  the first one added winning. Each direction is
+//                  checked on its own, so a dual arc over an existing
+//                  one way arc keeps its other half, where addDualArc
+//                  would drop both. Rebuilds the arc index if it's on.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::endBulk()
+{
+	if (!m_bulk)
+		return;
+
+	m_bulk = false;
+
+	vector<int> seen(slotCount(), -1);
+	int removed = 0;
+	for (int i = 0; i < slotCount(); ++i)
+	{
+		if (m_pNodes[i] != 0)
+			removed += m_pNodes[i]->removeRepeatedArcs(seen);
 	}
 
-	gop << "All previous pointers cleared." << endl;
+	if (m_indexArcs)
+		setArcIndex(true);
+
+	//Too many changes to list one by one
+	forgetJournal();
+
+	gop << "Bulk build done, " << removed << " repeated arcs removed." << endl;
 	gout(2);
 }
 
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::maxGs()
+bool Graph<NodeType, ArcType>::setArcWeight(int from, int to, ArcType weight)
 {
+	Arc* pArc = getArc(from, to);
+	if (pArc == 0)
+		return false;
 
-	for (int index = 0; index < m_maxNodes; ++index) {
-		if (m_pNodes[index] != 0)
-		{
-			m_pNodes[index]->setG(maxG);
+	ArcType oldWeight = pArc->weight();
+	pArc->setWeight(weight);
 
-			gop << m_pNodes[index]->data() << " G maxed." << endl;
-			gout(4);
-		}
+	if (!patchCsr(from, to, weight, false))
+		m_csrDirty = true;
+	//A cheaper arc can undercut the landmark bounds, a dearer one can't
+	else if (weight < oldWeight)
+		dropLandmarks();
+
+	journal(from, to);
+
+	gop << "\t" << "Arc from " << m_pNodes[from]->data() << " to " << m_pNodes[to]->data() << " now weighs " << weight << endl;
+	gout(3);
+
+	return true;
+}
+
+//Records one changed arc, keeping the journal to a bounded size
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::journal(int from, int to)
+{
+	const size_t limit = 1 << 16;
+
+	m_journal.push_back(make_pair(from, to));
+	++m_version;
+
+	//Drop the older half, anyone that far behind starts again
+	if (m_journal.size() > limit)
+	{
+		m_journal.erase(m_journal.begin(), m_journal.begin() + limit / 2);
+		m_journalStart += limit / 2;
 	}
+}
 
-	gop << "All G values maxed." << endl;
-	gout(2);
+//After changes too big to journal, nothing older than now can be caught up
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::forgetJournal()
+{
+	m_journal.clear();
+	m_journalStart = ++m_version;
+}
+
+// ----------------------------------------------------------------
+//  Name:           changesSince
+//  Description:    Lists the arcs added, removed or reweighted since
+//                  a version was read from version(). An arc may be
+//                  listed more than once. Weights changed straight
+//                  through a GraphArc aren't seen, use setArcWeight.
+//  Arguments:      The first parameter is the version last seen
+//                  The second has the from, to pairs appended.
+//  Return Value:   False if the journal doesn't go back that far (it
+//                  is bounded, and bulk builds clear it), in which case
+//                  the caller has to start again.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::changesSince(unsigned version, vector<pair<int, int>>& arcs) const
+{
+	if (version < m_journalStart || version > m_version)
+		return false;
+
+	arcs.insert(arcs.end(), m_journal.begin() + (version - m_journalStart), m_journal.end());
+	return true;
 }
 
+// ----------------------------------------------------------------
+//  Name:           setArcIndex
+//  Description:    Turns the hashed arc index on or off. With it on,
+//                  addArc, addDualArc and removeNode check for an
+//                  existing arc in O(1) rather than walking the arc
+//                  list, at the cost of a hash entry per arc. Worth it
+//                  for graphs built one arc at a time with busy nodes.
+//  Arguments:      True to build the index, false to drop it.
+//  Return Value:   None.
+// ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::maxHs()
+void Graph<NodeType, ArcType>::setArcIndex(bool on)
 {
+	m_indexArcs = on;
+	m_arcIndex.clear();
 
-	for (int index = 0; index < m_maxNodes; ++index) {
-		if (m_pNodes[index] != 0)
-		{
-			m_pNodes[index]->setH(maxH);
+	if (!on)
+		return;
 
-			gop << m_pNodes[index]->data() << " heuristic maxed." << endl;
-			gout(4);
-		}
+	for (int i = 0; i < slotCount(); ++i)
+	{
+		if (m_pNodes[i] == 0)
+			continue;
+
+		typename Node::ArcList::const_iterator iter = m_pNodes[i]->arcList().begin();
+		typename Node::ArcList::const_iterator endIter = m_pNodes[i]->arcList().end();
+		for (; iter != endIter; ++iter)
+			m_arcIndex.insert(arcKey(i, (*iter).node()->index()));
 	}
+}
 
-	gop << "All heuristic values maxed." << endl;
-	gout(2);
+template<class NodeType, class ArcType>
+// Dev-CPP doesn't like Arc* as the (typedef'd) return type?
+GraphArc<NodeType, ArcType>* Graph<NodeType, ArcType>::getArc( int from, int to ) {
+     Arc* pArc = 0;
+     // make sure the to and from nodes exist
+     if( exists(from) && exists(to) ) {
+         pArc = m_pNodes[from]->getArc( m_pNodes[to] );
+     }
+                
+     return pArc;
 }
 
+// ----------------------------------------------------------------
+//  Name:           patchCsr
+//  Description:    Changes one arc in both CSRs where it lies, so a
+//                  single edit doesn't rebuild the whole adjacency. A
+//                  removed arc becomes a self loop on its source (and
+//                  on its target in the reverse CSR): the searches skip
+//                  it since that node is already closed when its arcs
+//                  are walked. compact() squeezes them out.
+//  Arguments:      The first two parameters are the arc's ends
+//                  The third is its new weight
+//                  The last removes it instead.
+//  Return Value:   False if the CSRs are out of date or don't hold
+//                  the arc, the caller then marks them dirty.
+// ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-float Graph<NodeType, ArcType>::distanceBetween(const sf::Vector2f v1, const sf::Vector2f v2)
+bool Graph<NodeType, ArcType>::patchCsr(int from, int to, ArcType weight, bool remove)
 {
-	return sqrt(pow(v2.x - v1.x, 2) + pow(v2.y - v1.y, 2));
+	if (m_csrDirty)
+		return false;
+
+	int arc = m_csr.find(from, to);
+	int back = m_reverse.find(to, from);
+	if (arc == -1 || back == -1)
+		return false;
+
+	m_csr.setArc(arc, remove ? from : to, weight);
+	m_reverse.setArc(back, remove ? to : from, weight);
+	if (remove)
+		++m_deadArcs;
+
+	return true;
 }
 
+//Clears the landmarks when the arcs change under them
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::genMap()
+void Graph<NodeType, ArcType>::dropLandmarks()
 {
-	HeurMap map;
-	HeurVec temp;
-	Node* nodeI;
-	Node* nodeJ;
+	if (!m_landmarks.empty())
+	{
+		m_landmarks.clear();
+		gop << "Landmarks cleared, arcs changed." << endl;
+		gout(1);
+	}
+}
+
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::compact()
+{
+	m_csr.build(m_pNodes.data(), slotCount());
+	m_reverse.buildReverse(m_csr);
+	gatherPositions();
+	m_csrDirty = false;
+	m_deadArcs = 0;
+
+	//Landmark distances were for the old arcs
+	dropLandmarks();
 
-	int c = m_count;
-	map.reserve(c);
+	gop << "Compacted " << m_count << " nodes and " << m_csr.arcCount() << " arcs." << endl;
+	gout(2);
+}
 
-	//For each node I
+// ----------------------------------------------------------------
+//  Name:           genMap
+//  Description:    Makes the table of straight line distances between
+//                  every pair of nodes that mapLookup and the Map
+//                  search read. Only half is stored since the table is
+//                  symmetric. Rows are filled in parallel from flat x
+//                  and y arrays, see DistanceKernels.hpp. Lazy mode
+//                  keeps just the positions and works each distance out
+//                  when it's looked up, for graphs too big for n * n / 2
+//                  floats.
+//  Arguments:      The first parameter picks lazy mode
+//                  The second is the thread count, see workerCount.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::genMap(bool lazy, int threads)
+{
+	int c = slotCount();
+	m_mapSize = c;
+	m_mapLazy = lazy;
+
+	gatherPositions();
+
+	vector<int> missing;
 	for (int i = 0; i < c; ++i)
 	{
-		nodeI = m_pNodes[i];
-		temp.clear();
-		temp.reserve(c);
-		
-		//For each other node J (including I!)
-		for (int j = 0; j < c; ++j)
-		{
-			nodeJ = m_pNodes[j];
+		if (m_pNodes[i] == 0)
+			missing.push_back(i);
+	}
 
-			//Add J and the euclidian distance to it to the map
-			temp.push_back(make_pair(nodeJ->data(), distanceBetween(nodeI->position(), nodeJ->position())));
-		}
+	if (lazy)
+	{
+		vector<float>().swap(m_map);
 
-		//Then add I and the list of distances to the map
-		map.push_back(make_pair(nodeI->data(), temp));
+		gop << "Heuristic map set to lazy." << endl;
+		gout(1);
+		return;
 	}
 
+	m_map.resize((size_t)c * (c + 1) / 2);
+	float maxH = m_context.maxH();
+
+	parallelFor(c, [&](int i, int)
+	{
+		float* row = &m_map[(size_t)i * (i + 1) / 2];
+
+		//Row i against columns 0 to i, including itself
+		distances(Distance(), m_posX[i], m_posY[i], m_posX.data(), m_posY.data(), 0, i + 1, row);
+
+		//Distance is maximum to or from an empty slot
+		if (m_pNodes[i] == 0)
+			fill(row, row + i + 1, maxH);
+		else for (size_t k = 0; k < missing.size() && missing[k] < i; ++k)
+			row[missing[k]] = maxH;
+	}, threads);
+
 	gop << "Heuristic map generated." << endl;
 	gout(1);
-
-	m_map = map;
 }
 
+//Positions side by side, empty slots included (at 0, 0) so ids line up
 template<class NodeType, class ArcType>
-float Graph<NodeType, ArcType>::mapLookup(Node* pStart, Node* pEnd)
+void Graph<NodeType, ArcType>::gatherPositions()
 {
-	//Distance will be maximum if not found
-	float distance = maxH;
+	int c = slotCount();
+	m_posX.assign(c, 0);
+	m_posY.assign(c, 0);
 
-	//Find starting node in map
-	for (HeurMap::iterator mIter = m_map.begin(), mEnd = m_map.end(); mIter < mEnd; ++mIter)
+	for (int i = 0; i < c; ++i)
 	{
-		if (mIter->first == pStart->data())
+		if (m_pNodes[i] != 0)
 		{
-			//Find the second node in heuristic vector for first node
-			for (HeurVec::iterator vIter = mIter->second.begin(), vEnd = mIter->second.end(); vIter < vEnd; ++vIter)
-			{
-				if (vIter->first == pEnd->data())
-				{
-					distance = vIter->second;
-				}
-			}
+			m_posX[i] = m_pNodes[i]->position().x;
+			m_posY[i] = m_pNodes[i]->position().y;
 		}
 	}
+}
+
+template<class NodeType, class ArcType>
+float Graph<NodeType, ArcType>::mapLookup(int from, int to) const
+{
+	//Distance will be maximum if either node is newer than the map
+	if (from >= m_mapSize || to >= m_mapSize)
+		return m_context.maxH();
 
-	return distance;
+	if (from < to)
+		swap(from, to);
+
+	if (!m_mapLazy)
+		return m_map[(size_t)from * (from + 1) / 2 + to];
+
+	if (m_pNodes[from] == 0 || m_pNodes[to] == 0)
+		return m_context.maxH();
+
+	return Distance()(m_posX[from] - m_posX[to], m_posY[from] - m_posY[to]);
 }
 
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::mapNodes(Node* pEnd)
 {
-	float distance;
-	//lookup pEnd in the map, grab each distance and set it to the appropriate node
-	for (int i = 0, c = m_count; i < c; ++i)
+	mapNodes(m_context, pEnd->index());
+}
+
+//Copy the target's row of the map into each node's H in the context
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::mapNodes(SearchContext<ArcType>& ctx, int target) const
+{
+	if (ctx.size() < slotCount())
+		ctx.resize(slotCount());
+
+	ctx.resetH();
+	for (int i = 0; i < slotCount(); ++i)
 	{
-		m_pNodes[i]->setH(mapLookup(pEnd, m_pNodes[i]));
+		if (m_pNodes[i] != 0)
+			ctx.setH(i, mapLookup(target, i));
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           genLandmarks
+//  Description:    Picks landmarks and stores the costs to and from
+//                  them for the ALT heuristic, see Landmarks.hpp.
+//                  Cleared again whenever the arcs change.
+//  Arguments:      Number of landmarks to pick.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::genLandmarks(int count)
+{
+	if (m_csrDirty)
+		compact();
+
+	m_landmarks.build(m_csr, m_reverse, count);
+
+	gop << "Generated " << m_landmarks.count() << " landmarks:";
+	for (int i = 0; i < m_landmarks.count(); ++i)
+		gop << " " << m_pNodes[m_landmarks.landmark(i)]->data();
+	gop << endl;
+	gout(1);
+}
+
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::landmarkNodes(Node* pEnd)
+{
+	//Set each node's H to its landmark estimate to pEnd
+	LandmarkHeuristic<ArcType> heuristic(m_landmarks, pEnd->index());
+
+	m_context.resetH();
+	for (int i = 0; i < slotCount(); ++i)
+	{
+		if (m_pNodes[i] != 0)
+			m_context.setH(i, heuristic(i));
 	}
 }
 
@@ -482,15 +930,15 @@ void Graph<NodeType, ArcType>::depthFirst( Node* pNode, void (*pProcess)(Node*)
      if( pNode != 0 ) {
            // process the current node and mark it
            pProcess( pNode );
-           pNode->setMarked(true);
+           m_context.setMarked(pNode->index(), true);
 
            // go through each connecting node
-           list<Arc>::iterator iter = pNode->arcList().begin();
-           list<Arc>::iterator endIter = pNode->arcList().end();
+           typename Node::ArcList::const_iterator iter = pNode->arcList().begin();
+           typename Node::ArcList::const_iterator endIter = pNode->arcList().end();
         
 		   for( ; iter != endIter; ++iter) {
 			    // process the linked node if it isn't already marked.
-                if ( (*iter).node()->marked() == false ) {
+                if ( m_context.marked((*iter).node()->index()) == false ) {
                    depthFirst( (*iter).node(), pProcess);
                 }            
            }
@@ -516,7 +964,7 @@ void Graph<NodeType, ArcType>::breadthFirst( Node* pNode, void (*pProcess)(Node*
 	  queue<Node*> nodeQueue;        
 	  // place the first node on the queue, and mark it.
       nodeQueue.push( pNode );
-      pNode->setMarked(true);
+      m_context.setMarked(pNode->index(), true);
 
       // loop through the queue while there are nodes in it.
       while( nodeQueue.size() != 0 ) {
@@ -525,13 +973,13 @@ void Graph<NodeType, ArcType>::breadthFirst( Node* pNode, void (*pProcess)(Node*
 
          // add all of the child nodes that have not been 
          // marked into the queue
-         list<Arc>::const_iterator iter = nodeQueue.front()->arcList().begin();
-         list<Arc>::const_iterator endIter = nodeQueue.front()->arcList().end();
+         typename Node::ArcList::const_iterator iter = nodeQueue.front()->arcList().begin();
+         typename Node::ArcList::const_iterator endIter = nodeQueue.front()->arcList().end();
          
 		 for( ; iter != endIter; iter++ ) {
-              if ( (*iter).node()->marked() == false) {
+              if ( m_context.marked((*iter).node()->index()) == false) {
 				 // mark the node and add it to the queue.
-                 (*iter).node()->setMarked(true);
+                 m_context.setMarked((*iter).node()->index(), true);
                  nodeQueue.push( (*iter).node() );
               }
          }
@@ -564,7 +1012,7 @@ void Graph<NodeType, ArcType>::breadthFirstPlus(Node* pNode, Node* pTarget, void
 		bool found = false;
 		// place the first node on the queue, and mark it.
 		nodeQueue.push(pNode);
-		pNode->setMarked(true);
+		m_context.setMarked(pNode->index(), true);
 
 		// loop through the queue while there are nodes in it.
 		while (nodeQueue.size() != 0 && !found) {
@@ -573,21 +1021,21 @@ void Graph<NodeType, ArcType>::breadthFirstPlus(Node* pNode, Node* pTarget, void
 
 			// add all of the child nodes that have not been 
 			// marked into the queue
-			list<Arc>::const_iterator iter = nodeQueue.front()->arcList().begin();
-			list<Arc>::const_iterator endIter = nodeQueue.front()->arcList().end();
+			typename Node::ArcList::const_iterator iter = nodeQueue.front()->arcList().begin();
+			typename Node::ArcList::const_iterator endIter = nodeQueue.front()->arcList().end();
 
 			for (; iter != endIter && !found; iter++) {
 				//if the node is our target set found to true
 				if ((*iter).node() == pTarget)
 				{
-					(*iter).node()->setPrev(nodeQueue.front());
+					m_context.setPrev((*iter).node()->index(), nodeQueue.front()->index());
 					found = 1;
 				}
 				//else add it to the queue
-				else if ((*iter).node()->marked() == false) {
+				else if (m_context.marked((*iter).node()->index()) == false) {
 					// mark the node and add it to the queue.
-					(*iter).node()->setMarked(true);
-					(*iter).node()->setPrev(nodeQueue.front());
+					m_context.setMarked((*iter).node()->index(), true);
+					m_context.setPrev((*iter).node()->index(), nodeQueue.front()->index());
 					nodeQueue.push((*iter).node());
 				}
 			}
@@ -612,150 +1060,246 @@ void Graph<NodeType, ArcType>::UCS(Node* pStart, Node* pTarget, std::vector<Node
 	std::chrono::time_point<std::chrono::system_clock> start, end;
 	start = std::chrono::system_clock::now();
 
-	//Unmark, clear Prev, max G, set up first node
-	clearMarks();
-	clearPrevs();
-	maxGs();
-	pStart->setG(0);
-	pStart->setMarked(true);
+	//Arcs are read from the compacted adjacency
+	if (m_csrDirty)
+		compact();
 
-	//make & set up queue
-	priority_queue<Node*, vector<Node*>, NodeSearchCostComparer<NodeType, ArcType>> pq;
-	
-	//Start of UCS
-	pq.push(pStart);
-	
-	//Priority Queueue loop
-	while (!pq.empty() && pq.top() != pTarget)
+	//Search using the graph's own context
+#if GRAPH_TRACE
+	if (m_verbosity >= 2)
 	{
+		StreamTrace<NodeType, ArcType> trace(cout, m_pNodes.data());
+		UCS(m_context, pStart->index(), pTarget->index(), trace);
+	}
+	else
+#endif
+	UCS(m_context, pStart->index(), pTarget->index());
+	
+	//End timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
 
-		gop << "TOP: " << pq.top()->data() << endl;
-
-		//for each arc
-		for (list<Arc>::const_iterator iter = pq.top()->arcList().begin(), endIter = pq.top()->arcList().end(); iter != endIter; ++iter)
-		{
-			//Pull out the node to test
-			Node* childNode = iter->node();
-
-			//if the previous node is not top of the queue
-			if (childNode != pq.top()->getPrev())
-			{
-				//Get total weight of this route
-				int c = pq.top()->g() + iter->weight();
-
-				gop << "\t" << "Checking: " << pq.top()->data() << " -> " << childNode->data() << " [" << c << " < " << (childNode->g()) << "]" << endl;
+	gop << "\a\a=== UCS from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
+	gout(1);
 
-				//if it's lower than the weight of the current route
-				if (c < (childNode->g()))
-				{
-					//Set the node's internal weight to the arc from previous plus internal weight of previous
-					childNode->setG(c);
+	//Add the nodes to path
+	getPath(m_context, pTarget->index(), path);
+}
 
-					//Set previous pointer of the node to the previous node in the new path
-					childNode->setPrev(pq.top());
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::AStarLandmark(Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	gop << "\a=== Landmark A* from " << pStart->data() << " to " << pTarget->data() << " ===" << endl;
+	gout(2);
 
-					gop << "\t\t" << "True, " << childNode->data() << " g is now " << c << ", previous is now " << pq.top()->data() << endl;
-				}
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
 
-				else
-				{
-					if (childNode->getPrev() != 0)
-						gop << "\t\t" << "False, " << childNode->data() << " g remaining " << (childNode->g()) << ", previous remains " << childNode->getPrev()->data() << endl;
-					else gop << "\t\t" << "False, " << childNode->data() << " g remaining " << (childNode->g()) << ", previous remains NULL" << endl;
-				}
+	//Landmarks are built on the compacted adjacency
+	if (m_csrDirty)
+		compact();
 
-				//if not marked
-				if (childNode->marked() == false) {
-					//add it to the queue and mark
-					pq.push(childNode);
-					gop << "Queueing:  " << childNode->data() << endl;
-					childNode->setMarked(true);
-				}
-			}
-		}
-		gop << "Popping: " << pq.top()->data() << endl << endl;
-		gout(2);
+	if (m_landmarks.empty())
+		genLandmarks();
 
-		pq.pop();
+	//Init H Values
+	landmarkNodes(pTarget);
 
-		if (!pq.empty())
-			make_heap(const_cast<Node**>(&pq.top()), const_cast<Node**>(&pq.top()) + pq.size(), NodeSearchCostComparer<NodeType, ArcType>());
-		
+	//Search using the graph's own context
+#if GRAPH_TRACE
+	if (m_verbosity >= 2)
+	{
+		StreamTrace<NodeType, ArcType> trace(cout, m_pNodes.data());
+		AStar(m_context, pStart->index(), pTarget->index(), StoredHeuristic<ArcType>(m_context), trace);
 	}
-	
+	else
+#endif
+	AStar(m_context, pStart->index(), pTarget->index(), StoredHeuristic<ArcType>(m_context));
+
 	//End timer
 	end = std::chrono::system_clock::now();
 	std::chrono::duration<double> elapsed_seconds = end - start;
 
-	gop << "\a\a=== UCS from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
+	gop << "\a\a=== Landmark A* from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
+	gout(1);
+
+	//Add the nodes to path
+	getPath(m_context, pTarget->index(), path);
+}
+
+// ----------------------------------------------------------------
+//  Name:           AStarAnytime
+//  Description:    Anytime A* (see AnytimeSearch.hpp) on landmark
+//                  estimates. The first pass inflates H by the initial
+//                  weight and each pass after lowers it by step until
+//                  the route is optimal or the time is up. Every
+//                  solution is printed with its bound. The path is the
+//                  last completed solution's, a pass the time cut
+//                  short doesn't count.
+//  Arguments:      The first two parameters are the start and target
+//                  The third is the path to fill, empty if there's no
+//                  route or none was found in time
+//                  The fourth is the time allowed in seconds
+//                  The fifth is the first pass's weight, 1 or less
+//                  gives a single optimal pass
+//                  The last is how much the weight drops each pass.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::AStarAnytime(Node* pStart, Node* pTarget, std::vector<Node*>& path, double seconds, float initialWeight, float step)
+{
+	gop << "\a=== Anytime A* from " << pStart->data() << " to " << pTarget->data() << " ===" << endl;
+	gout(2);
+
+	//Landmarks are built on the compacted adjacency
+	if (m_csrDirty)
+		compact();
+
+	if (m_landmarks.empty())
+		genLandmarks();
+
+	SearchBudget budget;
+	budget.setTimeLimit(seconds);
+
+	AnytimeSearch<ArcType, LandmarkHeuristic<ArcType>> search(pStart->index(), pTarget->index(),
+		LandmarkHeuristic<ArcType>(m_landmarks, pTarget->index()), initialWeight, step);
+
+	while (search.improve(m_csr, budget))
+	{
+		typename AnytimeSearch<ArcType, LandmarkHeuristic<ArcType>>::Solution const & solution = search.best();
+		gop << "Weight " << solution.weight << ": cost " << solution.cost << ", within " << solution.bound << " of optimal, "
+			<< solution.expanded << " expanded (" << solution.seconds << "s)" << endl;
+		gout(1);
+	}
+
+	gop << "\a\a=== Anytime A* from " << pStart->data() << " to " << pTarget->data() << " complete. ("
+		<< search.solutions().size() << " solutions" << (search.optimal() ? ", optimal" : "") << ")===" << endl << endl;
 	gout(1);
 
 	//Add the nodes to path
 	path.clear();
-	while (pTarget->getPrev() != NULL)
+	if (search.found())
 	{
-		path.push_back(pTarget);
-		pTarget = pTarget->getPrev();
+		vector<int> indices;
+		search.getPath(indices);
+		for (size_t i = 0; i < indices.size(); ++i)
+			path.push_back(m_pNodes[indices[i]]);
 	}
-	path.push_back(pTarget);
+}
 
-	std::reverse(path.begin(), path.end());
+// ----------------------------------------------------------------
+//  Name:           UCS
+//  Description:    Uniform cost search on a caller owned context, which
+//                  is A* with no heuristic. The graph is only read, so
+//                  this may run on several threads at once as long as
+//                  each has its own context.
+//  Arguments:      The first parameter is the context to search with
+//                  The second and third are the start and target
+//                  indices, a target of -1 searches the whole graph
+//                  The fourth is the trace policy, see GraphTrace.hpp.
+//                  The context's budget applies, see SearchBudget.hpp.
+//  Return Value:   How the search ended, results are left in the context.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+SearchStatus Graph<NodeType, ArcType>::UCS(SearchContext<ArcType>& ctx, int start, int target) const
+{
+	NullTrace trace;
+	return AStar(ctx, start, target, ZeroHeuristic(), trace);
+}
+
+template<class NodeType, class ArcType>
+template<class Trace>
+SearchStatus Graph<NodeType, ArcType>::UCS(SearchContext<ArcType>& ctx, int start, int target, Trace& trace) const
+{
+	return AStar(ctx, start, target, ZeroHeuristic(), trace);
 }
 
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::InitAStar(Node* pTarget)
-{	
-	//Unmark, clear prev, max G, set up first node
-	clearMarks();
-	clearPrevs();
-	maxGs();
-	pTarget->setG(0);
-	pTarget->setMarked(true);
-
-	//Set up queue
-	priority_queue<Node*, vector<Node*>, NodeSearchCostComparer<NodeType, ArcType>> pq;
-	pq.push(pTarget);
-
-	//Priority Queue loop
-	while (!pq.empty() && pTarget != NULL)
+{
+	//Same H as InitAStar(ctx, target), the UCS only runs if the target isn't cached
+	vector<ArcType> const & distances = targetDistances(pTarget->index());
+
+	m_context.resetH();
+	for (int index = 0; index < (int)distances.size(); ++index)
 	{
-		//for each arc
-		for (list<Arc>::const_iterator iter = pq.top()->arcList().begin(),  endIter = pq.top()->arcList().end(); iter != endIter; ++iter)
-		{
-			//pull out the node to test
-			Node* childNode = iter->node();
+		if (distances[index] < m_context.maxG())
+			m_context.setH(index, distances[index] * m_heurMult);
+	}
+}
 
-			//If the previous node is not top of the queue
-			if (childNode != pq.top()->getPrev())
-			{
-				//Get total weight of this route
-				int c = pq.top()->g() + iter->weight();
+// ----------------------------------------------------------------
+//  Name:           targetDistances
+//  Description:    Cost of the cheapest route from a target to every
+//                  node, max G where there isn't one. Worked out with
+//                  a full UCS the first time, then kept in an LRU
+//                  cache (see DistanceCache.hpp) until the graph's
+//                  version moves on, so hot targets cost one lookup.
+//  Arguments:      The target index.
+//  Return Value:   The costs by node id. Only good until the next call.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+vector<ArcType> const & Graph<NodeType, ArcType>::targetDistances(int target)
+{
+	//Arcs are read from the compacted adjacency
+	if (m_csrDirty)
+		compact();
 
-				//if it's lower than the current weight
-				if (c < childNode->g())
-				{
-					//set internal weight to route weight
-					childNode->setG(c);
-				}
+	//Bulk arcs don't move the version, so nothing cached is trusted until endBulk
+	vector<ArcType> const * pCached = m_bulk ? 0 : m_targetCache.find(target, m_version);
+	if (pCached != 0)
+	{
+		gop << "Target costs for " << m_pNodes[target]->data() << " from cache." << endl;
+		gout(2);
+		return *pCached;
+	}
 
-				//if not marked
-				if (childNode->marked() == false)
-				{
-					//add it to the queue and unmark
-					pq.push(childNode);
-					childNode->setMarked(true);
-				}
-			}
-		}
+	//A cut short UCS would give wrong costs, so it runs without the budget
+	SearchBudget budget = m_context.budget();
+	m_context.setBudget(SearchBudget());
+	UCS(m_context, target, -1);
+	m_context.setBudget(budget);
 
-		//Set heuristic using multiplier
-		pq.top()->setH((pq.top()->g() * m_heurMult));
+	vector<ArcType>& distances = m_targetCache.insert(target, m_version, slotCount());
+	for (int index = 0; index < slotCount(); ++index)
+		distances[index] = m_context.marked(index) ? m_context.g(index) : m_context.maxG();
 
-		pq.pop();
+	return distances;
+}
 
-		if (!pq.empty())
-			make_heap(const_cast<Node**>(&pq.top()), const_cast<Node**>(&pq.top()) + pq.size(), class NodeSearchCostComparer<NodeType, ArcType>());
+// ----------------------------------------------------------------
+//  Name:           InitAStar
+//  Description:    Sets the H of every node in the context to the
+//                  multiplied cost of reaching it from the target.
+//  Arguments:      The first parameter is the context to fill
+//                  The second is the target index
+//                  The third, if given, traces the UCS.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::InitAStar(SearchContext<ArcType>& ctx, int target) const
+{
+	NullTrace trace;
+	InitAStar(ctx, target, trace);
+}
 
+template<class NodeType, class ArcType>
+template<class Trace>
+void Graph<NodeType, ArcType>::InitAStar(SearchContext<ArcType>& ctx, int target, Trace& trace) const
+{	
+	//Full UCS out from the target, the budget is for the A* that follows
+	SearchBudget budget = ctx.budget();
+	ctx.setBudget(SearchBudget());
+	UCS(ctx, target, -1, trace);
+	ctx.setBudget(budget);
+
+	//Set heuristic using multiplier, unreached nodes keep max H
+	ctx.resetH();
+	for (int index = 0; index < slotCount(); ++index)
+	{
+		if (ctx.marked(index))
+			ctx.setH(index, ctx.g(index) * m_heurMult);
 	}
 }
 
@@ -772,80 +1316,16 @@ void Graph<NodeType, ArcType>::AStar(Node* pStart, Node* pTarget, std::vector<No
 	//Init path h by way of UCS
 	InitAStar(pTarget);
 
-	//make & set up queue
-	priority_queue<Node*, vector<Node*>, ANodeSearchCostComparer<NodeType, ArcType>> pq;
-	
-	//Unmark, clear Prev, max G, set up first node
-	clearMarks();
-	clearPrevs();
-	maxGs();
-	pStart->setG(0);
-	pStart->setMarked(true);
-	
-	//Start of A*
-	pq.push(pStart);
-	
-	//Priority Queueue loop
-	while (!pq.empty() && pq.top() != pTarget)
+	//Search using the graph's own context
+#if GRAPH_TRACE
+	if (m_verbosity >= 2)
 	{
-	
-		gop << "TOP: " << pq.top()->data() << endl;
-	
-		//for each child node
-		list<Arc>::const_iterator iter = pq.top()->arcList().begin();
-		list<Arc>::const_iterator endIter = pq.top()->arcList().end();
-	
-		//Process all children of the top node
-		for (; iter != endIter; iter++) 
-		{
-			//Pull out the node to test
-			Node * childNode = iter->node();
-	
-			//if the previous node is not top of the queue & Not marked
-			if (childNode != pq.top()->getPrev() && !childNode->marked())
-			{
-	
-				//Get f of this route (Weight to parent + arc to child)
-				float fn = pq.top()->g() + iter->weight();
-	
-				gop << "\t" << "Checking: " << pq.top()->data() << " -> " << childNode->data() << " [" << fn << " < " << (childNode->g()) << "]" << endl;
-	
-				//if it's lower than the weight of the current route
-				if (fn < childNode->g())
-				{
-					//Set the node's internal weight to the arc from previous plus internal weight of previous
-					childNode->setG(fn);
-					//Set previous pointer of the node to the previous node in the new path
-					childNode->setPrev(pq.top());
-	
-					gop << "\t\t" << "True, " << childNode->data() << " weight is now " << fn << ", previous is now " << pq.top()->data() << endl;
-				}
-	
-				else
-				{
-					if (childNode->getPrev() != 0)
-						gop << "\t\t" << "False, " << childNode->data() << " remaining " << (childNode->g()) << ", previous remains " << childNode->getPrev()->data() << endl;
-					else gop << "\t\t" << "False, " << childNode->data() << " remaining " << (childNode->g()) << ", previous remains NULL" << endl;
-				}
-				
-				//if not marked
-				if (childNode->marked() == false) {
-					//add it to the queue and mark
-					pq.push(childNode);
-					gop << "Queueing:  " << childNode->data() << endl;
-					childNode->setMarked(true);
-				}
-			}
-		}
-		gop << "Popping: " << pq.top()->data() << endl << endl;
-		gout(2);
-	
-	
-		if (!pq.empty())
-			make_heap(const_cast<Node**>(&pq.top()), const_cast<Node**>(&pq.top()) + pq.size(), 
-			ANodeSearchCostComparer<NodeType, ArcType>());
-		pq.pop();
+		StreamTrace<NodeType, ArcType> trace(cout, m_pNodes.data());
+		AStar(m_context, pStart->index(), pTarget->index(), StoredHeuristic<ArcType>(m_context), trace);
 	}
+	else
+#endif
+	AStar(m_context, pStart->index(), pTarget->index(), StoredHeuristic<ArcType>(m_context));
 	
 	//End timer
 	end = std::chrono::system_clock::now();
@@ -855,15 +1335,7 @@ void Graph<NodeType, ArcType>::AStar(Node* pStart, Node* pTarget, std::vector<No
 	gout(1);
 	
 	//Add the nodes to path
-	path.clear();
-	while (pTarget->getPrev() != NULL)
-	{
-		path.push_back(pTarget);
-		pTarget = pTarget->getPrev();
-	}
-	path.push_back(pTarget);
-	
-	std::reverse(path.begin(), path.end());
+	getPath(m_context, pTarget->index(), path);
 }
 
 template<class NodeType, class ArcType>
@@ -879,101 +1351,378 @@ void Graph<NodeType, ArcType>::AStarPrecomp(Node* pStart, Node* pTarget, std::ve
 
 	//Init H Values
 	mapNodes(pTarget);
+
+	//Arcs are read from the compacted adjacency
+	if (m_csrDirty)
+		compact();
+
+	//Search using the graph's own context
+#if GRAPH_TRACE
+	if (m_verbosity >= 2)
+	{
+		StreamTrace<NodeType, ArcType> trace(cout, m_pNodes.data());
+		AStar(m_context, pStart->index(), pTarget->index(), StoredHeuristic<ArcType>(m_context), trace);
+	}
+	else
+#endif
+	AStar(m_context, pStart->index(), pTarget->index(), StoredHeuristic<ArcType>(m_context));
+
+	//End timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
+
+	gop << "\a\a=== A* from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
+	gout(1);
 	
-	//make & set up queue
-	priority_queue<Node*, vector<Node*>, ANodeSearchCostComparer<NodeType, ArcType>> pq;
+	//Add the nodes to path
+	getPath(m_context, pTarget->index(), path);
+}
 
-	//Unmark, clear Prev, max G, set up first node
-	clearMarks();
-	clearPrevs();
-	maxGs();
-	pStart->setG(0);
-	pStart->setMarked(true);
+// ----------------------------------------------------------------
+//  Name:           AStar
+//  Description:    A* search on a caller owned context, runs
+//                  aStarSearch on the compacted adjacency. Like UCS
+//                  this only reads the graph.
+//  Arguments:      The first parameter is the context to search with
+//                  The second and third are the start and target
+//                  indices
+//                  The fourth gives the H of a node index, see
+//                  Heuristics.hpp
+//                  The fifth is the trace policy, see GraphTrace.hpp.
+//                  The context's budget applies, see SearchBudget.hpp.
+//  Return Value:   How the search ended, results are left in the context.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Heuristic>
+SearchStatus Graph<NodeType, ArcType>::AStar(SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic) const
+{
+	NullTrace trace;
+	return AStar(ctx, start, target, heuristic, trace);
+}
 
-	//Start of A*
-	pq.push(pStart);
+template<class NodeType, class ArcType>
+template<class Heuristic, class Trace>
+SearchStatus Graph<NodeType, ArcType>::AStar(SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic, Trace& trace) const
+{
+	return aStarSearch(m_csr, ctx, start, target, heuristic, trace);
+}
 
-	//Priority Queueue loop
-	while (!pq.empty() && pq.top() != pTarget)
-	{
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::BidirectionalUCS(Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	gop << "\a=== Bidirectional UCS from " << pStart->data() << " to " << pTarget->data() << " ===" << endl;
+	gout(2);
 
-		gop << "TOP: " << pq.top()->data() << endl;
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
 
-		//for each child node
-		list<Arc>::const_iterator iter = pq.top()->arcList().begin();
-		list<Arc>::const_iterator endIter = pq.top()->arcList().end();
+	//Both directions are read from the compacted adjacency
+	if (m_csrDirty)
+		compact();
 
-		//Process all children of the top node
-		for (; iter != endIter; iter++)
-		{
-			//Pull out the node to test
-			Node * childNode = iter->node();
+	BidirectionalUCS(m_context, m_backContext, pStart->index(), pTarget->index());
 
-			//if the previous node is not top of the queue & Not marked
-			if (childNode != pq.top()->getPrev() && !childNode->marked())
-			{
+	//End timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
 
-				//Get f of this route (Weight to parent + arc to child)
-				float fn = pq.top()->g() + iter->weight();
+	gop << "\a\a=== Bidirectional UCS from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
+	gout(1);
 
-				gop << "\t" << "Checking: " << pq.top()->data() << " -> " << childNode->data() << " [" << fn << " < " << (childNode->g()) << "]" << endl;
+	//Add the nodes to path
+	getPath(m_context, pTarget->index(), path);
+}
 
-				//if it's lower than the weight of the current route
-				if (fn < childNode->g())
-				{
-					//Set the node's internal weight to the arc from previous plus internal weight of previous
-					childNode->setG(fn);
-					//Set previous pointer of the node to the previous node in the new path
-					childNode->setPrev(pq.top());
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::BidirectionalAStar(Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	gop << "\a=== Bidirectional A* from " << pStart->data() << " to " << pTarget->data() << " ===" << endl;
+	gout(2);
 
-					gop << "\t\t" << "True, " << childNode->data() << " weight is now " << fn << ", previous is now " << pq.top()->data() << endl;
-				}
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
 
-				else
-				{
-					if (childNode->getPrev() != 0)
-						gop << "\t\t" << "False, " << childNode->data() << " remaining " << (childNode->g()) << ", previous remains " << childNode->getPrev()->data() << endl;
-					else gop << "\t\t" << "False, " << childNode->data() << " remaining " << (childNode->g()) << ", previous remains NULL" << endl;
-				}
+	//Landmarks are built on the compacted adjacency
+	if (m_csrDirty)
+		compact();
 
-				//if not marked
-				if (childNode->marked() == false) {
-					//add it to the queue and mark
-					pq.push(childNode);
-					gop << "Queueing:  " << childNode->data() << endl;
-					childNode->setMarked(true);
-				}
-			}
-		}
-		gop << "Popping: " << pq.top()->data() << endl << endl;
-		gout(2);
-	if (!pq.empty())
-			make_heap(const_cast<Node**>(&pq.top()), const_cast<Node**>(&pq.top()) + pq.size(), 
-			ANodeSearchCostComparer<NodeType, ArcType>());
-		pq.pop();
+	//Landmarks bound both directions, which a single stored H can't
+	if (m_landmarks.empty())
+		genLandmarks();
 
-		
-	}
+	BidirectionalAStar(m_context, m_backContext, pStart->index(), pTarget->index(),
+		LandmarkHeuristic<ArcType>(m_landmarks, pTarget->index()), LandmarkSourceHeuristic<ArcType>(m_landmarks, pStart->index()));
 
 	//End timer
 	end = std::chrono::system_clock::now();
 	std::chrono::duration<double> elapsed_seconds = end - start;
 
-	gop << "\a\a=== A* from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
+	gop << "\a\a=== Bidirectional A* from " << pStart->data() << " to " << pTarget->data() << " complete. (" << elapsed_seconds.count() << "s)===" << endl << endl;
 	gout(1);
-	
+
 	//Add the nodes to path
+	getPath(m_context, pTarget->index(), path);
+}
+
+// ----------------------------------------------------------------
+//  Name:           BidirectionalUCS
+//  Description:    Bidirectional search over the compacted adjacency
+//                  and its reverse, see bidirectionalSearch. The
+//                  backward half of the route is copied into the
+//                  first context, so it reads the same as after UCS.
+//  Arguments:      The first two parameters are the forward and
+//                  backward contexts
+//                  The third and fourth are the start and target
+//                  indices
+//                  For A*, the last two give the estimated cost from
+//                  a node to the target and from the start to a node,
+//                  both must be consistent.
+//                  The first context's budget applies.
+//  Return Value:   How the search ended, results are left in the
+//                  first context.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+SearchStatus Graph<NodeType, ArcType>::BidirectionalUCS(SearchContext<ArcType>& ctx, SearchContext<ArcType>& back, int start, int target) const
+{
+	return BidirectionalAStar(ctx, back, start, target, ZeroHeuristic(), ZeroHeuristic());
+}
+
+template<class NodeType, class ArcType>
+template<class ToTarget, class FromStart>
+SearchStatus Graph<NodeType, ArcType>::BidirectionalAStar(SearchContext<ArcType>& ctx, SearchContext<ArcType>& back, int start, int target, ToTarget toTarget, FromStart fromStart) const
+{
+	int meet;
+	SearchStatus status = bidirectionalSearch(m_csr, m_reverse, ctx, back, start, target, toTarget, fromStart, meet);
+	joinSearches(ctx, back, meet);
+	return status;
+}
+
+// ----------------------------------------------------------------
+//  Name:           getPath
+//  Description:    Follows the previous indices in a context back
+//                  from the target and lists the nodes start first.
+//                  If a limit stopped the search and its budget asked
+//                  for a partial path, it's to the closest node the
+//                  search reached instead. Without one the path is
+//                  left empty, as any route to the target is only
+//                  tentative.
+//  Arguments:      The first parameter is the searched context
+//                  The second is the target index
+//                  The third is the path to fill, as indices or nodes.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::getPath(SearchContext<ArcType> const & ctx, int target, std::vector<int>& path) const
+{
 	path.clear();
-	while (pTarget->getPrev() != NULL)
+
+	//Stopped by a limit, the statuses after Unreachable
+	if (ctx.status() > Unreachable)
 	{
-		path.push_back(pTarget);
-		pTarget = pTarget->getPrev();
+		if (!ctx.budget().partialPath || ctx.closest() == -1)
+			return;
+
+		target = ctx.closest();
 	}
-	path.push_back(pTarget);
+
+	while (ctx.prev(target) != -1)
+	{
+		path.push_back(target);
+		target = ctx.prev(target);
+	}
+	path.push_back(target);
 	
 	std::reverse(path.begin(), path.end());
 }
 
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::getPath(SearchContext<ArcType> const & ctx, int target, std::vector<Node*>& path) const
+{
+	vector<int> indices;
+	getPath(ctx, target, indices);
+
+	path.clear();
+	for (size_t i = 0; i < indices.size(); ++i)
+		path.push_back(m_pNodes[indices[i]]);
+}
+
+// ----------------------------------------------------------------
+//  Name:           solveBatch
+//  Description:    Runs many independent start/target queries across
+//                  a pool of threads, each with its own context. Uses
+//                  landmarks if there are any, else the heuristic map
+//                  if there is one, else UCS.
+//  Arguments:      The first two parameters are the queries as
+//                  (start index, target index) pairs
+//                  The next two receive every path back to back,
+//                  path i is pathNodes[pathOffsets[i], pathOffsets[i + 1]),
+//                  laid out as getPath gives it, and empty if either
+//                  end of the query isn't a node
+//                  The last is the thread count, 0 for one per core.
+//                  Every query keeps to the graph's search budget, see
+//                  setSearchBudget, a deadline is for the whole batch.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::solveBatch(pair<int, int> const * queries, int count, vector<int>& pathNodes, vector<int>& pathOffsets, int threads)
+{
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
+
+	//Every thread reads the same compacted adjacency
+	if (m_csrDirty)
+		compact();
+
+	threads = workerCount(count, threads);
+
+	//Per thread scratch and path buffers
+	vector<SearchContext<ArcType>> contexts(threads);
+	for (int thread = 0; thread < threads; ++thread)
+		contexts[thread].setBudget(m_context.budget());
+	vector<vector<int>> buffers(threads);
+	vector<vector<int>> paths(threads);
+
+	//Where each query's path ended up (thread, first node, length)
+	struct Result { int thread; int begin; int length; };
+	vector<Result> results(count);
+
+	bool useLandmarks = hasLandmarks();
+	bool useMap = hasMap();
+
+	parallelFor(count, [&](int query, int thread)
+	{
+		SearchContext<ArcType>& ctx = contexts[thread];
+		vector<int>& buffer = buffers[thread];
+		int from = queries[query].first;
+		int to = queries[query].second;
+
+		Result& result = results[query];
+		result.thread = thread;
+		result.begin = buffer.size();
+		result.length = 0;
+
+		if (!exists(from) || !exists(to))
+			return;
+
+		if (useLandmarks)
+			AStar(ctx, from, to, LandmarkHeuristic<ArcType>(m_landmarks, to));
+		else if (useMap)
+			AStar(ctx, from, to, [&](int node) { return mapLookup(to, node); });
+		else AStar(ctx, from, to, ZeroHeuristic());
+
+		vector<int>& path = paths[thread];
+		getPath(ctx, to, path);
+		buffer.insert(buffer.end(), path.begin(), path.end());
+		result.length = path.size();
+	}, threads);
+
+	//Gather the paths into one buffer in query order
+	pathOffsets.resize(count + 1);
+	pathOffsets[0] = 0;
+	for (int query = 0; query < count; ++query)
+		pathOffsets[query + 1] = pathOffsets[query] + results[query].length;
+
+	pathNodes.resize(pathOffsets[count]);
+	for (int query = 0; query < count; ++query)
+	{
+		Result const & result = results[query];
+		vector<int> const & buffer = buffers[result.thread];
+		std::copy(buffer.begin() + result.begin, buffer.begin() + result.begin + result.length, pathNodes.begin() + pathOffsets[query]);
+	}
+
+	//End timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
+
+	gop << "=== Batch of " << count << " queries on " << threads << " threads complete. (" << elapsed_seconds.count() << "s)===" << endl;
+	gout(1);
+}
+
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::solveBatch(vector<pair<int, int>> const & queries, vector<int>& pathNodes, vector<int>& pathOffsets, int threads)
+{
+	solveBatch(queries.empty() ? NULL : &queries[0], queries.size(), pathNodes, pathOffsets, threads);
+}
+
+// ----------------------------------------------------------------
+//  Name:           distanceMatrix
+//  Description:    Cheapest route cost between every source and every
+//                  target. One UCS per source, spread across a pool of
+//                  threads, each stopping once all of the targets are
+//                  settled (see oneToManySearch). Repeated targets are
+//                  only searched for once.
+//  Arguments:      The first two parameters are the source and target
+//                  indices
+//                  The third receives the costs, row per source, max G
+//                  where there's no route or a node doesn't exist
+//                  The last is the thread count, 0 for one per core.
+//                  Each row keeps to the graph's search budget, see
+//                  setSearchBudget. Targets a limit stopped short of
+//                  keep max G.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::distanceMatrix(vector<int> const & sources, vector<int> const & targets, vector<ArcType>& matrix, int threads)
+{
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
+
+	//Every thread reads the same compacted adjacency
+	if (m_csrDirty)
+		compact();
+
+	int rows = (int)sources.size();
+	int columns = (int)targets.size();
+	matrix.assign((size_t)rows * columns, m_context.maxG());
+
+	//Flag each distinct target once
+	vector<char> isTarget(slotCount(), 0);
+	int distinct = 0;
+	for (int column = 0; column < columns; ++column)
+	{
+		int target = targets[column];
+		if (exists(target) && !isTarget[target])
+		{
+			isTarget[target] = 1;
+			++distinct;
+		}
+	}
+
+	threads = workerCount(rows, threads);
+	vector<SearchContext<ArcType>> contexts(threads);
+	for (int thread = 0; thread < threads; ++thread)
+		contexts[thread].setBudget(m_context.budget());
+
+	parallelFor(rows, [&](int row, int thread)
+	{
+		if (!exists(sources[row]) || distinct == 0)
+			return;
+
+		SearchContext<ArcType>& ctx = contexts[thread];
+		oneToManySearch(m_csr, ctx, sources[row], isTarget, distinct);
+
+		//Targets not settled keep max G, a queued g may not be final
+		ArcType* out = &matrix[(size_t)row * columns];
+		for (int column = 0; column < columns; ++column)
+		{
+			int target = targets[column];
+			if (exists(target) && ctx.closed(target))
+				out[column] = ctx.g(target);
+		}
+	}, threads);
+
+	//End timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
+
+	gop << "=== " << rows << " x " << columns << " distance matrix on " << threads << " threads complete. (" << elapsed_seconds.count() << "s)===" << endl;
+	gout(1);
+}
+
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::gout(int verbosity)
 {
@@ -0,0 +1,249 @@
+#ifndef GRAPHCSR_H
+#define GRAPHCSR_H
+
+#include <list>
+#include <vector>
+
+template <class NodeType, class ArcType> class GraphArc;
+template <class NodeType, class ArcType> class GraphNode;
+
+// ----------------------------------------------------------------
+//  Name:           GraphCSR
+//  Description:    Compressed sparse row copy of a graph's
+//                  adjacency. The arcs leaving node n are stored in
+//                  [begin(n), end(n)) of the target and weight arrays,
+//                  so expanding a node walks contiguous memory instead
+//                  of a linked list. Only single arcs change in place,
+//                  see setArc.
+// ----------------------------------------------------------------
+template<class ArcType>
+class GraphCSR {
+private:
+	std::vector<int> m_offsets; //First arc of each node, plus one past the last arc
+	std::vector<int> m_targets; //Index of the node each arc points to
+	std::vector<ArcType> m_weights; //Weight of each arc
+
+public:
+	GraphCSR() {}
+
+	// Accessors
+	int nodeCount() const { return m_offsets.empty() ? 0 : (int)m_offsets.size() - 1; }
+	int arcCount() const { return (int)m_targets.size(); }
+	bool empty() const { return m_offsets.empty(); }
+
+	//Arc range of a node
+	int begin(int node) const { return m_offsets[node]; }
+	int end(int node) const { return m_offsets[node + 1]; }
+
+	//Arc data
+	int target(int arc) const { return m_targets[arc]; }
+	ArcType weight(int arc) const { return m_weights[arc]; }
+
+	//First arc of node going to target, -1 if there isn't one
+	int find(int node, int target) const;
+
+	//Point an arc somewhere else or reweigh it, the ranges stay as they are
+	void setArc(int arc, int target, ArcType weight) { m_targets[arc] = target; m_weights[arc] = weight; }
+
+	//Raw arrays, for writing out
+	int const * offsetData() const { return m_offsets.data(); }
+	int const * targetData() const { return m_targets.data(); }
+	ArcType const * weightData() const { return m_weights.data(); }
+
+	void clear();
+
+	//Build from an array of node pointers, null slots become nodes with no arcs
+	template<class NodeType>
+	void build(GraphNode<NodeType, ArcType>* const * pNodes, int size);
+
+	//Build with every arc of another CSR turned around
+	void buildReverse(GraphCSR const & forward);
+
+	//Build from a list of arcs, repeats of a pair keep their first weight
+	void build(int nodes, std::vector<int> const & from, std::vector<int> const & to, std::vector<ArcType> const & weights, bool dual);
+
+	//Take over ready made arrays, offsets must have nodes + 1 entries
+	void assign(std::vector<int>& offsets, std::vector<int>& targets, std::vector<ArcType>& weights);
+};
+
+template<class ArcType>
+void GraphCSR<ArcType>::clear()
+{
+	m_offsets.clear();
+	m_targets.clear();
+	m_weights.clear();
+}
+
+template<class ArcType>
+int GraphCSR<ArcType>::find(int node, int target) const
+{
+	for (int arc = begin(node), endArc = end(node); arc != endArc; ++arc)
+	{
+		if (m_targets[arc] == target)
+			return arc;
+	}
+
+	return -1;
+}
+
+template<class ArcType>
+void GraphCSR<ArcType>::assign(std::vector<int>& offsets, std::vector<int>& targets, std::vector<ArcType>& weights)
+{
+	//Swapped in, so the caller's vectors are left empty
+	m_offsets.swap(offsets);
+	m_targets.swap(targets);
+	m_weights.swap(weights);
+	offsets.clear();
+	targets.clear();
+	weights.clear();
+}
+
+template<class ArcType>
+template<class NodeType>
+void GraphCSR<ArcType>::build(GraphNode<NodeType, ArcType>* const * pNodes, int size)
+{
+	clear();
+
+	//Count arcs first so the arrays are only allocated once
+	int arcs = 0;
+	for (int n = 0; n < size; ++n)
+	{
+		if (pNodes[n] != 0)
+			arcs += pNodes[n]->arcList().size();
+	}
+
+	m_offsets.reserve(size + 1);
+	m_targets.reserve(arcs);
+	m_weights.reserve(arcs);
+
+	//Lay each node's arcs out one after the other
+	for (int n = 0; n < size; ++n)
+	{
+		m_offsets.push_back(m_targets.size());
+
+		if (pNodes[n] == 0)
+			continue;
+
+		for (typename GraphNode<NodeType, ArcType>::ArcList::const_iterator iter = pNodes[n]->arcList().begin(), endIter = pNodes[n]->arcList().end(); iter != endIter; ++iter)
+		{
+			m_targets.push_back(iter->node()->index());
+			m_weights.push_back(iter->weight());
+		}
+	}
+
+	m_offsets.push_back(m_targets.size());
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Bulk build from parallel arc arrays. A counting
+//                  sort by source keeps the arcs of each node in list
+//                  order, then repeats of the same pair are dropped so
+//                  the first one wins. O(nodes + arcs).
+//  Arguments:      The first parameter is the number of node slots
+//                  The next three are the arcs, ends outside
+//                  [0, nodes) are skipped
+//                  The last adds every arc both ways if set.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+void GraphCSR<ArcType>::build(int nodes, std::vector<int> const & from, std::vector<int> const & to, std::vector<ArcType> const & weights, bool dual)
+{
+	clear();
+
+	int count = (int)from.size();
+	int sides = dual ? 2 : 1;
+
+	//Count the arcs leaving each node
+	std::vector<int> start(nodes + 1, 0);
+	for (int i = 0; i < count; ++i)
+	{
+		if (from[i] < 0 || to[i] < 0 || from[i] >= nodes || to[i] >= nodes)
+			continue;
+
+		++start[from[i] + 1];
+		if (dual)
+			++start[to[i] + 1];
+	}
+
+	for (int n = 0; n < nodes; ++n)
+		start[n + 1] += start[n];
+
+	//Sort arc ids into their source's range, each arc's reverse is id + count
+	std::vector<int> order(start[nodes]);
+	std::vector<int> next(start.begin(), start.end() - 1);
+	for (int i = 0; i < count; ++i)
+	{
+		if (from[i] < 0 || to[i] < 0 || from[i] >= nodes || to[i] >= nodes)
+			continue;
+
+		for (int side = 0; side < sides; ++side)
+			order[next[side ? to[i] : from[i]]++] = i + side * count;
+	}
+
+	//Copy out, skipping pairs already seen for this node
+	std::vector<int> seen(nodes, -1);
+	m_offsets.resize(nodes + 1);
+	m_targets.reserve(order.size());
+	m_weights.reserve(order.size());
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		m_offsets[n] = (int)m_targets.size();
+
+		for (int i = start[n]; i < start[n + 1]; ++i)
+		{
+			int arc = order[i] % count;
+			int target = order[i] < count ? to[arc] : from[arc];
+
+			if (seen[target] == n)
+				continue;
+
+			seen[target] = n;
+			m_targets.push_back(target);
+			m_weights.push_back(weights[arc]);
+		}
+	}
+
+	m_offsets[nodes] = (int)m_targets.size();
+}
+
+// ----------------------------------------------------------------
+//  Name:           buildReverse
+//  Description:    Transposes another CSR, so the arcs of node n here
+//                  are the arcs that point to n there. Counting sort,
+//                  O(nodes + arcs).
+//  Arguments:      The forward CSR.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+void GraphCSR<ArcType>::buildReverse(GraphCSR const & forward)
+{
+	int nodes = forward.nodeCount();
+	int arcs = forward.arcCount();
+
+	//Count the arcs coming into each node
+	m_offsets.assign(nodes + 1, 0);
+	for (int arc = 0; arc < arcs; ++arc)
+		++m_offsets[forward.target(arc) + 1];
+
+	for (int n = 0; n < nodes; ++n)
+		m_offsets[n + 1] += m_offsets[n];
+
+	//Drop each arc into its target's range, pointing back at its source
+	m_targets.resize(arcs);
+	m_weights.resize(arcs);
+	std::vector<int> next(m_offsets.begin(), m_offsets.end() - 1);
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		for (int arc = forward.begin(n), endArc = forward.end(n); arc != endArc; ++arc)
+		{
+			int slot = next[forward.target(arc)]++;
+			m_targets[slot] = n;
+			m_weights[slot] = forward.weight(arc);
+		}
+	}
+}
+
+#endif
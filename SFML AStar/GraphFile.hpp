@@ -0,0 +1,462 @@
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Graph.hpp"
+
+// ----------------------------------------------------------------
+//  Binary graph file, laid out so it can be mapped and searched in
+//  place. Every section starts on a 64 byte boundary:
+//
+//      GraphFileHeader
+//      int offsets[nodes + 1]      CSR, see GraphCSR
+//      int targets[arcs]
+//      ArcType weights[arcs]
+//      float positions[nodes * 2]  x, y per node
+//      NodeType data[nodes]        node payloads, copied as bytes
+//      char present[nodes]         1 if the slot holds a node
+//
+//  NodeType and ArcType must be plain data. The header records their
+//  sizes, and a file written with other types won't open.
+// ----------------------------------------------------------------
+struct GraphFileHeader {
+	char magic[4]; //"SFAG"
+	unsigned version; //GRAPHFILE_VERSION
+	unsigned nodeSize; //sizeof(NodeType)
+	unsigned arcSize; //sizeof(ArcType)
+	long long nodes; //Node slots
+	long long arcs;
+	long long offsets; //Byte offset of each section from the start of the file
+	long long targets;
+	long long weights;
+	long long positions;
+	long long data;
+	long long present;
+	long long size; //Total file size
+};
+
+#define GRAPHFILE_VERSION 1
+
+//Read only mapping of a whole file
+class MappedFile {
+private:
+	char const * m_pData;
+	size_t m_size;
+#ifdef _WIN32
+	HANDLE m_file;
+	HANDLE m_mapping;
+#else
+	int m_file;
+#endif
+
+	MappedFile(MappedFile const &);
+	MappedFile& operator=(MappedFile const &);
+
+public:
+	MappedFile();
+	~MappedFile() { close(); }
+
+	bool open(std::string const & filename);
+	void close();
+
+	char const * data() const { return m_pData; }
+	size_t size() const { return m_size; }
+};
+
+// ----------------------------------------------------------------
+//  Name:           GraphFileView
+//  Description:    A mapped graph file used in place. It has the
+//                  GraphCSR adjacency interface, so aStarSearch and
+//                  the other search templates run straight on the
+//                  mapped arrays with nothing parsed or copied.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class GraphFileView {
+private:
+	MappedFile m_file;
+	GraphFileHeader const * m_pHeader;
+	int const * m_offsets;
+	int const * m_targets;
+	ArcType const * m_weights;
+	float const * m_positions;
+	NodeType const * m_data;
+	char const * m_present;
+
+	bool validate() const;
+
+public:
+	GraphFileView() : m_pHeader(0) {}
+
+	//Map a file, false if it's missing, not a graph file for these types, or damaged
+	bool open(std::string const & filename);
+	void close() { m_file.close(); m_pHeader = 0; }
+	bool isOpen() const { return m_pHeader != 0; }
+
+	// Adjacency, see GraphCSR
+	int nodeCount() const { return m_pHeader ? (int)m_pHeader->nodes : 0; }
+	int arcCount() const { return m_pHeader ? (int)m_pHeader->arcs : 0; }
+	int begin(int node) const { return m_offsets[node]; }
+	int end(int node) const { return m_offsets[node + 1]; }
+	int target(int arc) const { return m_targets[arc]; }
+	ArcType weight(int arc) const { return m_weights[arc]; }
+
+	// Node attributes
+	bool present(int node) const { return m_present[node] != 0; }
+	sf::Vector2f position(int node) const { return sf::Vector2f(m_positions[node * 2], m_positions[node * 2 + 1]); }
+	NodeType const & data(int node) const { return m_data[node]; }
+
+	//Build an editable Graph from the file, for the UI
+	void copyTo(Graph<NodeType, ArcType>& graph) const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           writeGraphFile
+//  Description:    Writes a graph file from a CSR and node arrays.
+//  Arguments:      The first parameter is the file to write
+//                  The second is the adjacency
+//                  The last three are the per node positions (x, y
+//                  pairs), payloads and presence flags.
+//  Return Value:   False if the file couldn't be written.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool writeGraphFile(std::string const & filename, GraphCSR<ArcType> const & csr,
+	std::vector<float> const & positions, std::vector<NodeType> const & data, std::vector<char> const & present)
+{
+	long long nodes = csr.nodeCount();
+	long long arcs = csr.arcCount();
+
+	//Sections one after the other, each rounded up to 64 bytes
+	GraphFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SFAG", 4);
+	header.version = GRAPHFILE_VERSION;
+	header.nodeSize = sizeof(NodeType);
+	header.arcSize = sizeof(ArcType);
+	header.nodes = nodes;
+	header.arcs = arcs;
+
+	long long at = sizeof(GraphFileHeader);
+	long long* sections[] = { &header.offsets, &header.targets, &header.weights, &header.positions, &header.data, &header.present };
+	long long sizes[] = { (nodes + 1) * (long long)sizeof(int), arcs * (long long)sizeof(int), arcs * (long long)sizeof(ArcType),
+		nodes * 2 * (long long)sizeof(float), nodes * (long long)sizeof(NodeType), nodes };
+	for (int i = 0; i < 6; ++i)
+	{
+		at = (at + 63) / 64 * 64;
+		*sections[i] = at;
+		at += sizes[i];
+	}
+	header.size = at;
+
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	void const * arrays[] = { csr.offsetData(), csr.targetData(), csr.weightData(), positions.data(), data.data(), present.data() };
+
+	file.write((char const *)&header, sizeof(header));
+	long long written = sizeof(header);
+	char const padding[64] = {};
+	for (int i = 0; i < 6; ++i)
+	{
+		file.write(padding, *sections[i] - written);
+		file.write((char const *)arrays[i], sizes[i]);
+		written = *sections[i] + sizes[i];
+	}
+
+	return file.good();
+}
+
+// ----------------------------------------------------------------
+//  Name:           writeGraphFile
+//  Description:    Writes a Graph's compacted adjacency, positions
+//                  and payloads.
+//  Arguments:      The first parameter is the graph
+//                  The second is the file to write.
+//  Return Value:   False if the file couldn't be written.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool writeGraphFile(Graph<NodeType, ArcType>& graph, std::string const & filename)
+{
+	//Removed arcs are still in the CSR as self loops, don't write them
+	if (graph.deadArcs() > 0)
+		graph.compact();
+
+	GraphCSR<ArcType> const & csr = graph.csr();
+	int nodes = csr.nodeCount();
+
+	std::vector<float> positions((size_t)nodes * 2, 0.0f);
+	std::vector<NodeType> data(nodes);
+	std::vector<char> present(nodes, 0);
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		if (!graph.exists(n))
+			continue;
+
+		GraphNode<NodeType, ArcType> const * pNode = graph.nodeArray()[n];
+		positions[n * 2] = pNode->position().x;
+		positions[n * 2 + 1] = pNode->position().y;
+		data[n] = pNode->data();
+		present[n] = 1;
+	}
+
+	return writeGraphFile(filename, csr, positions, data, present);
+}
+
+// ----------------------------------------------------------------
+//  Name:           convertTextGraph
+//  Description:    Converts the text format loadGraphDrawable reads,
+//                  "data x y" per node (ids in file order) and
+//                  "from to weight" per dual arc, to a graph file.
+//                  The CSR is built straight from the arc list, see
+//                  GraphCSR::build. Like addDualArc, a repeated pair
+//                  keeps its first weight.
+//  Arguments:      The first two parameters are the node and arc files
+//                  The third is the graph file to write.
+//  Return Value:   False if a file couldn't be read or written.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool convertTextGraph(std::string const & nodesFile, std::string const & arcsFile, std::string const & outFile)
+{
+	std::ifstream nodeStream(nodesFile.c_str());
+	std::ifstream arcStream(arcsFile.c_str());
+	if (!nodeStream || !arcStream)
+		return false;
+
+	std::vector<NodeType> data;
+	std::vector<float> positions;
+	NodeType value;
+	float x, y;
+	while (nodeStream >> value >> x >> y)
+	{
+		data.push_back(value);
+		positions.push_back(x);
+		positions.push_back(y);
+	}
+
+	int nodes = (int)data.size();
+
+	std::vector<int> from, to;
+	std::vector<ArcType> weight;
+	int a, b;
+	ArcType w;
+	while (arcStream >> a >> b >> w)
+	{
+		from.push_back(a);
+		to.push_back(b);
+		weight.push_back(w);
+	}
+
+	GraphCSR<ArcType> csr;
+	csr.build(nodes, from, to, weight, true);
+
+	return writeGraphFile(outFile, csr, positions, data, std::vector<char>(nodes, 1));
+}
+
+inline MappedFile::MappedFile() : m_pData(0), m_size(0)
+{
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#else
+	m_file = -1;
+#endif
+}
+
+inline bool MappedFile::open(std::string const & filename)
+{
+	close();
+
+#ifdef _WIN32
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(m_file, &size);
+	m_size = (size_t)size.QuadPart;
+
+	m_mapping = m_size ? CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	m_pData = m_mapping ? (char const *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+#else
+	m_file = ::open(filename.c_str(), O_RDONLY);
+	if (m_file == -1)
+		return false;
+
+	struct stat info;
+	fstat(m_file, &info);
+	m_size = (size_t)info.st_size;
+
+	void* p = m_size ? mmap(0, m_size, PROT_READ, MAP_SHARED, m_file, 0) : MAP_FAILED;
+	m_pData = p == MAP_FAILED ? 0 : (char const *)p;
+#endif
+
+	if (!m_pData)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+inline void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#else
+	if (m_pData)
+		munmap((void*)m_pData, m_size);
+	if (m_file != -1)
+		::close(m_file);
+	m_file = -1;
+#endif
+
+	m_pData = 0;
+	m_size = 0;
+}
+
+template<class NodeType, class ArcType>
+bool GraphFileView<NodeType, ArcType>::open(std::string const & filename)
+{
+	close();
+
+	if (!m_file.open(filename) || m_file.size() < sizeof(GraphFileHeader))
+		return false;
+
+	GraphFileHeader const * pHeader = (GraphFileHeader const *)m_file.data();
+	if (memcmp(pHeader->magic, "SFAG", 4) != 0 || pHeader->version != GRAPHFILE_VERSION ||
+		pHeader->nodeSize != sizeof(NodeType) || pHeader->arcSize != sizeof(ArcType) || pHeader->size > (long long)m_file.size())
+	{
+		m_file.close();
+		return false;
+	}
+
+	char const * base = m_file.data();
+	m_pHeader = pHeader;
+	m_offsets = (int const *)(base + pHeader->offsets);
+	m_targets = (int const *)(base + pHeader->targets);
+	m_weights = (ArcType const *)(base + pHeader->weights);
+	m_positions = (float const *)(base + pHeader->positions);
+	m_data = (NodeType const *)(base + pHeader->data);
+	m_present = base + pHeader->present;
+
+	if (!validate())
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+//Whether a section of count elements fits in the file past the header
+inline bool sectionFits(long long offset, long long count, size_t elemSize, size_t fileSize)
+{
+	if (offset < (long long)sizeof(GraphFileHeader) || offset > (long long)fileSize || offset % 64 != 0)
+		return false;
+
+	return count >= 0 && (unsigned long long)count <= (fileSize - (size_t)offset) / elemSize;
+}
+
+// ----------------------------------------------------------------
+//  Name:           validate
+//  Description:    Checks a mapped file before anything reads it:
+//                  every section lies inside the mapping, the offsets
+//                  run from 0 up to the arc count without going back,
+//                  and every target is a node slot. One pass over the
+//                  offsets and targets, nothing else is read.
+//  Arguments:      None.
+//  Return Value:   False if the file is truncated or damaged.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool GraphFileView<NodeType, ArcType>::validate() const
+{
+	GraphFileHeader const & header = *m_pHeader;
+	size_t size = m_file.size();
+
+	//Indices are ints
+	if (header.nodes < 0 || header.arcs < 0 || header.nodes >= INT_MAX || header.arcs > INT_MAX)
+		return false;
+
+	if (!sectionFits(header.offsets, header.nodes + 1, sizeof(int), size) ||
+		!sectionFits(header.targets, header.arcs, sizeof(int), size) ||
+		!sectionFits(header.weights, header.arcs, sizeof(ArcType), size) ||
+		!sectionFits(header.positions, header.nodes * 2, sizeof(float), size) ||
+		!sectionFits(header.data, header.nodes, sizeof(NodeType), size) ||
+		!sectionFits(header.present, header.nodes, 1, size))
+		return false;
+
+	int nodes = (int)header.nodes;
+	int arcs = (int)header.arcs;
+
+	if (m_offsets[0] != 0 || m_offsets[nodes] != arcs)
+		return false;
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		if (m_offsets[n + 1] < m_offsets[n])
+			return false;
+	}
+
+	for (int arc = 0; arc < arcs; ++arc)
+	{
+		if (m_targets[arc] < 0 || m_targets[arc] >= nodes)
+			return false;
+	}
+
+	return true;
+}
+
+template<class NodeType, class ArcType>
+void GraphFileView<NodeType, ArcType>::copyTo(Graph<NodeType, ArcType>& graph) const
+{
+	int nodes = nodeCount();
+	graph.reserve(nodes);
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		if (!present(n))
+			continue;
+
+		graph.addNode(data(n), n);
+		graph.nodeArray()[n]->setPosition(position(n));
+	}
+
+	//Copied as one CSR, so no arc pays addArc's duplicate check
+	std::vector<int> offsets(m_offsets, m_offsets + nodes + 1);
+	std::vector<int> targets(m_targets, m_targets + arcCount());
+	std::vector<ArcType> weights(m_weights, m_weights + arcCount());
+
+	GraphCSR<ArcType> arcs;
+	arcs.assign(offsets, targets, weights);
+	graph.addArcs(arcs);
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef GRAPHGENERATORS_H
+#define GRAPHGENERATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Graph.hpp"
+
+// ----------------------------------------------------------------
+//  Synthetic graphs for benchmarking. Every generator is seeded and
+//  uses its own random number generator, so the same seed gives the
+//  same graph on every platform and standard library. Node positions
+//  are set and arc weights are never below the straight line distance,
+//  so the map heuristic stays admissible on all of them.
+// ----------------------------------------------------------------
+
+//xorshift64*, small and the same everywhere, unlike the <random> distributions
+class GraphRandom {
+private:
+	unsigned long long m_state;
+
+public:
+	explicit GraphRandom(unsigned long long seed) : m_state(seed * 2685821657736338717ull + 1) {}
+
+	unsigned next()
+	{
+		m_state ^= m_state >> 12;
+		m_state ^= m_state << 25;
+		m_state ^= m_state >> 27;
+		return (unsigned)((m_state * 2685821657736338717ull) >> 32);
+	}
+
+	//0 to count - 1
+	int uniform(int count) { return (int)((unsigned long long)next() * count >> 32); }
+
+	//0 to 1, not including 1
+	float uniformFloat() { return (next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+//Weight of an arc between two positions, the distance rounded up and at least 1
+template<class ArcType>
+ArcType generatedWeight(sf::Vector2f const & a, sf::Vector2f const & b)
+{
+	float dx = a.x - b.x;
+	float dy = a.y - b.y;
+	float d = std::ceil(std::sqrt(dx * dx + dy * dy));
+	return d < 1 ? (ArcType)1 : (ArcType)d;
+}
+
+// ----------------------------------------------------------------
+//  Name:           generateGeometric
+//  Description:    Random geometric graph: nodes scattered over a
+//                  square, each joined both ways to every node within
+//                  a radius chosen to give about the requested average
+//                  degree. Neighbours are found through a bucket grid
+//                  the size of the radius.
+//  Arguments:      The first parameter is the graph to fill, empty
+//                  The second is the number of nodes
+//                  The third is the average degree wanted
+//                  The fourth is the seed
+//                  The last is the side of the square.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void generateGeometric(Graph<NodeType, ArcType>& graph, int nodes, float degree, unsigned seed, float size = 1000)
+{
+	GraphRandom random(seed);
+	graph.reserve(nodes);
+
+	for (int i = 0; i < nodes; ++i)
+	{
+		graph.addNode((NodeType)i, i);
+		graph.nodeArray()[i]->setPosition(sf::Vector2f(random.uniformFloat() * size, random.uniformFloat() * size));
+	}
+
+	//Expected neighbours in a circle of radius r is n * pi * r^2 / size^2
+	float radius = size * std::sqrt(degree / (3.14159265f * nodes));
+	int cells = std::max(1, std::min(nodes, (int)(size / radius)));
+	float cellSize = size / cells;
+
+	//Nodes by bucket, counting sort
+	std::vector<int> bucketOf(nodes);
+	std::vector<int> start(cells * cells + 1, 0);
+	for (int i = 0; i < nodes; ++i)
+	{
+		sf::Vector2f p = graph.nodeArray()[i]->position();
+		int cx = std::min(cells - 1, (int)(p.x / cellSize));
+		int cy = std::min(cells - 1, (int)(p.y / cellSize));
+		bucketOf[i] = cy * cells + cx;
+		++start[bucketOf[i] + 1];
+	}
+
+	for (int b = 0; b < cells * cells; ++b)
+		start[b + 1] += start[b];
+
+	std::vector<int> members(nodes);
+	std::vector<int> next(start.begin(), start.end() - 1);
+	for (int i = 0; i < nodes; ++i)
+		members[next[bucketOf[i]]++] = i;
+
+	//Each pair once, from the lower id, so no duplicate checks are needed
+	graph.beginBulk();
+	for (int i = 0; i < nodes; ++i)
+	{
+		sf::Vector2f p = graph.nodeArray()[i]->position();
+		int cx = bucketOf[i] % cells;
+		int cy = bucketOf[i] / cells;
+
+		for (int y = std::max(0, cy - 1); y <= std::min(cells - 1, cy + 1); ++y)
+		{
+			for (int x = std::max(0, cx - 1); x <= std::min(cells - 1, cx + 1); ++x)
+			{
+				int b = y * cells + x;
+				for (int k = start[b]; k < start[b + 1]; ++k)
+				{
+					int j = members[k];
+					if (j <= i)
+						continue;
+
+					sf::Vector2f q = graph.nodeArray()[j]->position();
+					float dx = p.x - q.x;
+					float dy = p.y - q.y;
+					if (dx * dx + dy * dy <= radius * radius)
+						graph.addDualArc(i, j, generatedWeight<ArcType>(p, q));
+				}
+			}
+		}
+	}
+	graph.endBulk();
+
+	graph.compact();
+}
+
+// ----------------------------------------------------------------
+//  Name:           generateGrid
+//  Description:    4-connected grid with a share of its cells blocked
+//                  at random. A blocked cell has no node, so the ids
+//                  stay y * width + x with holes where the blocks are.
+//  Arguments:      The first parameter is the graph to fill, empty
+//                  The next two are the grid size in cells
+//                  The fourth is the share of cells blocked, 0 to 1
+//                  The fifth is the seed
+//                  The last is the distance between cells.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void generateGrid(Graph<NodeType, ArcType>& graph, int width, int height, float obstacles, unsigned seed, float spacing = 10)
+{
+	GraphRandom random(seed);
+	graph.reserve(width * height);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			if (random.uniformFloat() < obstacles)
+				continue;
+
+			int id = y * width + x;
+			graph.addNode((NodeType)id, id);
+			graph.nodeArray()[id]->setPosition(sf::Vector2f(x * spacing, y * spacing));
+		}
+	}
+
+	graph.beginBulk();
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			int id = y * width + x;
+			if (!graph.exists(id))
+				continue;
+
+			//Right and down, addDualArc skips missing nodes
+			if (x + 1 < width)
+				graph.addDualArc(id, id + 1, (ArcType)spacing);
+			if (y + 1 < height)
+				graph.addDualArc(id, id + width, (ArcType)spacing);
+		}
+	}
+	graph.endBulk();
+
+	graph.compact();
+}
+
+// ----------------------------------------------------------------
+//  Name:           generateScaleFree
+//  Description:    Barabasi-Albert preferential attachment. Starts
+//                  from a small clique, then each new node joins links
+//                  existing nodes, picked with chance in proportion to
+//                  their degree, which grows a few large hubs. Nodes
+//                  are placed at random and weighted by distance.
+//  Arguments:      The first parameter is the graph to fill, empty
+//                  The second is the number of nodes
+//                  The third is the arcs each new node adds, both ways
+//                  The fourth is the seed
+//                  The last is the side of the square.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void generateScaleFree(Graph<NodeType, ArcType>& graph, int nodes, int links, unsigned seed, float size = 1000)
+{
+	GraphRandom random(seed);
+	graph.reserve(nodes);
+	links = std::max(1, std::min(links, nodes - 1));
+
+	for (int i = 0; i < nodes; ++i)
+	{
+		graph.addNode((NodeType)i, i);
+		graph.nodeArray()[i]->setPosition(sf::Vector2f(random.uniformFloat() * size, random.uniformFloat() * size));
+	}
+
+	//Every arc end, so a uniform pick from here is a pick by degree
+	std::vector<int> ends;
+	ends.reserve((size_t)nodes * links * 2);
+
+	graph.beginBulk();
+	int seedNodes = std::min(nodes, links + 1);
+	for (int i = 0; i < seedNodes; ++i)
+	{
+		for (int j = i + 1; j < seedNodes; ++j)
+		{
+			graph.addDualArc(i, j, generatedWeight<ArcType>(graph.nodeArray()[i]->position(), graph.nodeArray()[j]->position()));
+			ends.push_back(i);
+			ends.push_back(j);
+		}
+	}
+
+	std::vector<int> picked;
+	for (int i = seedNodes; i < nodes; ++i)
+	{
+		//Distinct targets, links is small so a linear check is fine
+		picked.clear();
+		while ((int)picked.size() < links)
+		{
+			int j = ends[random.uniform((int)ends.size())];
+			if (std::find(picked.begin(), picked.end(), j) == picked.end())
+				picked.push_back(j);
+		}
+
+		for (size_t k = 0; k < picked.size(); ++k)
+		{
+			int j = picked[k];
+			graph.addDualArc(i, j, generatedWeight<ArcType>(graph.nodeArray()[i]->position(), graph.nodeArray()[j]->position()));
+			ends.push_back(i);
+			ends.push_back(j);
+		}
+	}
+	graph.endBulk();
+
+	graph.compact();
+}
+
+#endif
@@ -2,8 +2,11 @@
 #define GRAPHNODE_H
 
 #include <list>
+#include <vector>
 #include <SFML/System/Vector2.hpp>
 
+#include "Arena.hpp"
+
 // Forward references
 template <typename NodeType, typename ArcType> class GraphArc;
 
@@ -15,48 +18,44 @@ private:
 typedef GraphArc<NodeType, ArcType> Arc;
 typedef GraphNode<NodeType, ArcType> Node;
 
+public:
+	//Arcs are list nodes drawn from the owning graph's arena, if it has one
+	typedef list<Arc, ArenaAllocator<Arc>> ArcList;
+
+private:
     NodeType m_data;
-    list<Arc> m_arcList;
-	Node* m_prevNode;
-    bool m_marked;
-	ArcType m_g; //Actual distance, used for UCS and A*
-	int m_h; //Heuristic, used for A*
+    ArcList m_arcList;
 	sf::Vector2f m_pos; //Position, used for drawing
+	int m_index; //Slot in the graph's node array
 
 public:
 	//Constructor
-	GraphNode() : m_prevNode(NULL), m_g(0), m_marked(false) {}
+	GraphNode() : m_data(), m_index(-1) {}
+	explicit GraphNode(ArenaAllocator<Arc> const & allocator) : m_data(), m_arcList(allocator), m_index(-1) {}
 
     // Accessor functions
-    list<Arc> const & arcList() const { return m_arcList; }
-    bool marked() const { return m_marked; }
+    ArcList const & arcList() const { return m_arcList; }
 	NodeType const & data() const { return m_data; }
-	ArcType const & g() const { return m_g; }
-	int const & h() const { return m_h; }
 	sf::Vector2f const & position() const { return m_pos; }
+	int index() const { return m_index; }
 	
     // Manipulator functions
     void setData(NodeType data) { m_data = data; }
-    void setMarked(bool mark) { m_marked = mark; }
-	void setG(ArcType g) { m_g = g; }
-	void setH(float h) { m_h = h; }
 	void setPosition(sf::Vector2f position) { m_pos = position; }
+	void setIndex(int index) { m_index = index; }
 
 	//Arcs
     Arc* getArc( Node* pNode );  
     void addArc( Node* pNode, ArcType pWeight );
 	void removeArc(Node* pNode);
-
-	//Previous pointer
-	Node* getPrev() { return m_prevNode; }
-	void setPrev(Node* newPrev) { m_prevNode = newPrev; }
+	int removeRepeatedArcs(std::vector<int>& seen);
 };
 
 template<typename NodeType, typename ArcType>
 GraphArc<NodeType, ArcType>* GraphNode<NodeType, ArcType>::getArc( Node* pNode ) {
 
-     list<Arc>::iterator iter = m_arcList.begin();
-     list<Arc>::iterator endIter = m_arcList.end();
+     typename ArcList::iterator iter = m_arcList.begin();
+     typename ArcList::iterator endIter = m_arcList.end();
      Arc* pArc = 0;
      
      // find the arc that matches the node
@@ -82,19 +81,50 @@ void GraphNode<NodeType, ArcType>::addArc( Node* pNode, ArcType weight ) {
 
 template<typename NodeType, typename ArcType>
 void GraphNode<NodeType, ArcType>::removeArc( Node* pNode ) {
-     list<Arc>::iterator iter = m_arcList.begin();
-     list<Arc>::iterator endIter = m_arcList.end();
+     typename ArcList::iterator iter = m_arcList.begin();
+     typename ArcList::iterator endIter = m_arcList.end();
 
-     int size = m_arcList.size();
-     // find the arc that matches the node
-     for( ; iter != endIter && m_arcList.size() == size;  
-                                                    ++iter ) {
+     // find the arc that matches the node, erase by position as arcs
+     // can't be compared
+     for( ; iter != endIter; ++iter ) {
           if ( (*iter).node() == pNode) {
-             m_arcList.remove( (*iter) );
+             m_arcList.erase( iter );
+             return;
           }                           
      }
 }
 
+// ----------------------------------------------------------------
+//  Name:           removeRepeatedArcs
+//  Description:    Drops every arc to a node an earlier arc already
+//                  goes to, so the first one added wins as it would
+//                  with addArc's check. One pass, no sorting, so the
+//                  arcs that are left keep their order.
+//  Arguments:      Scratch indexed by node id, at least as big as the
+//                  graph. Entries equal to this node's index are taken
+//                  as seen, so one vector serves every node untouched.
+//  Return Value:   Number of arcs removed.
+// ----------------------------------------------------------------
+template<typename NodeType, typename ArcType>
+int GraphNode<NodeType, ArcType>::removeRepeatedArcs(std::vector<int>& seen) {
+	int removed = 0;
+	typename ArcList::iterator iter = m_arcList.begin();
+
+	while (iter != m_arcList.end()) {
+		int& mark = seen[(*iter).node()->index()];
+		if (mark == m_index) {
+			iter = m_arcList.erase(iter);
+			++removed;
+		}
+		else {
+			mark = m_index;
+			++iter;
+		}
+	}
+
+	return removed;
+}
+
 #include "GraphArc.hpp"
 
 #endif
@@ -0,0 +1,487 @@
+#ifndef GRAPHSEARCH_H
+#define GRAPHSEARCH_H
+
+#include <vector>
+
+#include "SearchContext.hpp"
+#include "Heuristics.hpp"
+#include "GraphTrace.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           aStarSearch
+//  Description:    The A* loop every search in the project runs on.
+//                  It only needs an adjacency with nodeCount(),
+//                  begin(n), end(n), target(arc) and weight(arc), so
+//                  it works on a GraphCSR or any other view laid out
+//                  the same way. The adjacency is only read.
+//  Arguments:      The first parameter is the adjacency to search
+//                  The second is the context to search with
+//                  The third and fourth are the start and target
+//                  indices, a target of -1 searches everything
+//                  The fifth gives the H of a node index, see
+//                  Heuristics.hpp
+//                  The sixth is the trace policy, see GraphTrace.hpp.
+//                  The context's budget (see SearchBudget.hpp) can
+//                  stop the search early, the closest node popped is
+//                  then kept for a partial path.
+//  Return Value:   How the search ended, also left in the context
+//                  along with the results.
+// ----------------------------------------------------------------
+template<class Adjacency, class ArcType, class Heuristic, class Trace>
+SearchStatus aStarSearch(Adjacency const & adj, SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic, Trace& trace)
+{
+	//New generation unmarks, clears prev and maxes G, set up first node
+	if (ctx.size() < adj.nodeCount())
+		ctx.resize(adj.nodeCount());
+	ctx.reset();
+	ctx.setG(start, 0);
+	ctx.setMarked(start, true);
+
+	//Start of A*
+	IndexedHeap<float>& open = ctx.open();
+	open.push(start, heuristic(start));
+
+	//Limits are only checked if there are any
+	SearchBudget const & budget = ctx.budget();
+	bool limited = budget.limited();
+	SearchStatus status = Complete;
+	int expansions = 0;
+	int closest = start;
+	float closestH = open.topKey();
+
+	//Priority Queueue loop
+	while (!open.empty() && open.top() != target)
+	{
+		//Stop at the first limit reached, keeping the closest node so far
+		if (limited)
+		{
+			status = budget.check(expansions++, (float)ctx.g(open.top()));
+			if (status != Complete)
+				break;
+
+			float topH = open.topKey() - (float)ctx.g(open.top());
+			if (topH < closestH)
+			{
+				closestH = topH;
+				closest = open.top();
+			}
+		}
+
+		//Pop the node with the lowest f, its g can't get any lower
+		int top = open.pop();
+		trace.pop(top);
+
+		//Process all children of the top node
+		for (int arc = adj.begin(top), endArc = adj.end(top); arc != endArc; ++arc)
+		{
+			//Pull out the node to test
+			int child = adj.target(arc);
+
+			//Skip nodes that have already been popped
+			if (ctx.closed(child))
+				continue;
+
+			//Get g of this route (Weight to parent + arc to child)
+			ArcType gn = ctx.g(top) + adj.weight(arc);
+			trace.check(top, child, gn, ctx.g(child));
+
+			//if it's lower than the weight of the current route
+			if (gn < ctx.g(child))
+			{
+				bool queued = !ctx.marked(child);
+
+				//Set the node's internal weight to the arc from previous plus internal weight of previous
+				ctx.setG(child, gn);
+				//Set previous of the node to the previous node in the new path
+				ctx.setPrev(child, top);
+				trace.improve(child, gn, top, queued);
+
+				//Queue it on g + h if it's new, otherwise move it up the queue
+				open.pushOrDecrease(child, gn + heuristic(child));
+				ctx.setMarked(child, true);
+			}
+
+			else trace.keep(child, ctx.g(child), ctx.prev(child));
+		}
+
+		trace.expanded(top);
+	}
+
+	//Nothing left to search and the target never came up
+	if (status == Complete && open.empty() && target != -1)
+		status = Unreachable;
+
+	//Reached the target, but by a route dearer than allowed
+	else if (status == Complete && !open.empty() && budget.costLimited() && (float)ctx.g(target) > budget.maxCost)
+		status = CostLimit;
+
+	ctx.setStatus(status, limited ? closest : -1);
+	return status;
+}
+
+//Same without tracing
+template<class Adjacency, class ArcType, class Heuristic>
+SearchStatus aStarSearch(Adjacency const & adj, SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic)
+{
+	NullTrace trace;
+	return aStarSearch(adj, ctx, start, target, heuristic, trace);
+}
+
+// ----------------------------------------------------------------
+//  Name:           aStarSearchBatched
+//  Description:    aStarSearch, but the H of every child a node
+//                  improves is asked for in one call once all its arcs
+//                  are relaxed, so a SIMD heuristic can do them
+//                  together. The heuristic needs a batch form,
+//                      void operator()(int const * nodes, int count, float* h)
+//                  as PositionHeuristic and GridHeuristic have.
+//  Arguments:      As aStarSearch.
+//  Return Value:   As aStarSearch.
+// ----------------------------------------------------------------
+template<class Adjacency, class ArcType, class Heuristic, class Trace>
+SearchStatus aStarSearchBatched(Adjacency const & adj, SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic, Trace& trace)
+{
+	if (ctx.size() < adj.nodeCount())
+		ctx.resize(adj.nodeCount());
+	ctx.reset();
+	ctx.setG(start, 0);
+	ctx.setMarked(start, true);
+
+	IndexedHeap<float>& open = ctx.open();
+	open.push(start, heuristic(start));
+
+	//Limits are only checked if there are any
+	SearchBudget const & budget = ctx.budget();
+	bool limited = budget.limited();
+	SearchStatus status = Complete;
+	int expansions = 0;
+	int closest = start;
+	float closestH = open.topKey();
+
+	//Children waiting for their H, flushed early if a node has lots of arcs
+	const int batchSize = 64;
+	int children[batchSize];
+	float h[batchSize];
+	int batched = 0;
+
+	auto flush = [&]()
+	{
+		heuristic(children, batched, h);
+		for (int i = 0; i < batched; ++i)
+			open.pushOrDecrease(children[i], ctx.g(children[i]) + h[i]);
+		batched = 0;
+	};
+
+	while (!open.empty() && open.top() != target)
+	{
+		//Stop at the first limit reached, keeping the closest node so far
+		if (limited)
+		{
+			status = budget.check(expansions++, (float)ctx.g(open.top()));
+			if (status != Complete)
+				break;
+
+			float topH = open.topKey() - (float)ctx.g(open.top());
+			if (topH < closestH)
+			{
+				closestH = topH;
+				closest = open.top();
+			}
+		}
+
+		int top = open.pop();
+		trace.pop(top);
+
+		for (int arc = adj.begin(top), endArc = adj.end(top); arc != endArc; ++arc)
+		{
+			int child = adj.target(arc);
+
+			if (ctx.closed(child))
+				continue;
+
+			ArcType gn = ctx.g(top) + adj.weight(arc);
+			trace.check(top, child, gn, ctx.g(child));
+
+			if (gn < ctx.g(child))
+			{
+				bool queued = !ctx.marked(child);
+
+				ctx.setG(child, gn);
+				ctx.setPrev(child, top);
+				ctx.setMarked(child, true);
+				trace.improve(child, gn, top, queued);
+
+				//Queued with its final g when the batch is flushed
+				children[batched++] = child;
+				if (batched == batchSize)
+					flush();
+			}
+
+			else trace.keep(child, ctx.g(child), ctx.prev(child));
+		}
+
+		if (batched > 0)
+			flush();
+
+		trace.expanded(top);
+	}
+
+	//Nothing left to search and the target never came up
+	if (status == Complete && open.empty() && target != -1)
+		status = Unreachable;
+
+	//Reached the target, but by a route dearer than allowed
+	else if (status == Complete && !open.empty() && budget.costLimited() && (float)ctx.g(target) > budget.maxCost)
+		status = CostLimit;
+
+	ctx.setStatus(status, limited ? closest : -1);
+	return status;
+}
+
+//Same without tracing
+template<class Adjacency, class ArcType, class Heuristic>
+SearchStatus aStarSearchBatched(Adjacency const & adj, SearchContext<ArcType>& ctx, int start, int target, Heuristic heuristic)
+{
+	NullTrace trace;
+	return aStarSearchBatched(adj, ctx, start, target, heuristic, trace);
+}
+
+// ----------------------------------------------------------------
+//  Name:           oneToManySearch
+//  Description:    UCS from one start that stops as soon as every
+//                  flagged target has been settled, rather than
+//                  running to one target or over the whole graph.
+//  Arguments:      The first parameter is the adjacency to search
+//                  The second is the context to search with
+//                  The third is the start index
+//                  The fourth flags the targets, nonzero by node index
+//                  The last is how many nodes are flagged.
+//                  The context's budget applies, the targets settled
+//                  before a limit stopped it still have their costs.
+//  Return Value:   How the search ended, also left in the context.
+//                  Settled targets are closed with their g in the
+//                  context.
+// ----------------------------------------------------------------
+template<class Adjacency, class ArcType>
+SearchStatus oneToManySearch(Adjacency const & adj, SearchContext<ArcType>& ctx, int start, std::vector<char> const & isTarget, int targets)
+{
+	if (ctx.size() < adj.nodeCount())
+		ctx.resize(adj.nodeCount());
+	ctx.reset();
+	ctx.setG(start, 0);
+	ctx.setMarked(start, true);
+
+	IndexedHeap<float>& open = ctx.open();
+	open.push(start, 0);
+
+	//Limits are only checked if there are any
+	SearchBudget const & budget = ctx.budget();
+	bool limited = budget.limited();
+	SearchStatus status = Complete;
+	int expansions = 0;
+
+	int settled = 0;
+	while (!open.empty())
+	{
+		//Stop at the first limit reached, targets settled so far keep their costs
+		if (limited)
+		{
+			status = budget.check(expansions++, (float)ctx.g(open.top()));
+			if (status != Complete)
+				break;
+		}
+
+		int top = open.pop();
+
+		//Last target settled, nothing further out is wanted
+		if (isTarget[top] && ++settled == targets)
+			break;
+
+		for (int arc = adj.begin(top), endArc = adj.end(top); arc != endArc; ++arc)
+		{
+			int child = adj.target(arc);
+			if (ctx.closed(child))
+				continue;
+
+			ArcType gn = ctx.g(top) + adj.weight(arc);
+			if (gn < ctx.g(child))
+			{
+				ctx.setG(child, gn);
+				ctx.setPrev(child, top);
+				open.pushOrDecrease(child, (float)gn);
+				ctx.setMarked(child, true);
+			}
+		}
+	}
+
+	//Everything reachable searched and some targets never came up
+	if (status == Complete && settled < targets)
+		status = Unreachable;
+
+	ctx.setStatus(status, -1);
+	return status;
+}
+
+//Expands one node on one side of bidirectionalSearch, updating the best meeting point
+template<class Adjacency, class ArcType, class Potential>
+void expandSide(Adjacency const & adj, SearchContext<ArcType>& ctx, SearchContext<ArcType> const & other, float sign, Potential& potential, ArcType& best, int& meet)
+{
+	int top = ctx.open().pop();
+
+	for (int arc = adj.begin(top), endArc = adj.end(top); arc != endArc; ++arc)
+	{
+		int child = adj.target(arc);
+		if (ctx.closed(child))
+			continue;
+
+		ArcType gn = ctx.g(top) + adj.weight(arc);
+		if (gn < ctx.g(child))
+		{
+			ctx.setG(child, gn);
+			ctx.setPrev(child, top);
+			ctx.open().pushOrDecrease(child, gn + sign * potential(child));
+			ctx.setMarked(child, true);
+
+			//The other side has been here, so there's a route through it
+			if (other.marked(child) && gn + other.g(child) < best)
+			{
+				best = gn + other.g(child);
+				meet = child;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           bidirectionalSearch
+//  Description:    Searches forward from the start and backward from
+//                  the target at the same time, always expanding the
+//                  side with the lower key, and keeps the cheapest
+//                  route seen where the two frontiers touch (mu).
+//                  For A* both sides use the average potential
+//                      pf(v) = (toTarget(v) - fromStart(v)) / 2
+//                  forward and -pf(v) backward, which stays consistent
+//                  if the two estimates are. With keys k = g + p the
+//                  search can stop once kf + kb >= mu, as nothing left
+//                  on either list can give a cheaper route. With zero
+//                  estimates this is plain bidirectional UCS.
+//  Arguments:      The first two parameters are the adjacency and the
+//                  same adjacency turned around, which can be a
+//                  different type (a view such as ReversedGrid)
+//                  The next two are the contexts for each side
+//                  The next two are the start and target indices
+//                  The next two give the estimated cost from a node to
+//                  the target and from the start to a node
+//                  The last receives the index of the node the best
+//                  route meets at, -1 if there isn't one.
+//                  The forward context's budget applies to both sides,
+//                  its cost limit against the sum of the two lowest
+//                  keys, which no route left can beat. A partial path
+//                  is to the forward node closest to the target, or to
+//                  the target itself once the sides have met (after
+//                  joinSearches).
+//  Return Value:   How the search ended, also left in the forward
+//                  context.
+// ----------------------------------------------------------------
+template<class Forward, class Reverse, class ArcType, class ToTarget, class FromStart>
+SearchStatus bidirectionalSearch(Forward const & forward, Reverse const & reverse, SearchContext<ArcType>& fctx, SearchContext<ArcType>& bctx, int start, int target, ToTarget toTarget, FromStart fromStart, int& meet)
+{
+	if (fctx.size() < forward.nodeCount())
+		fctx.resize(forward.nodeCount());
+	if (bctx.size() < reverse.nodeCount())
+		bctx.resize(reverse.nodeCount());
+
+	fctx.reset();
+	bctx.reset();
+
+	//Forward potential, the backward one is its negative
+	auto potential = [&](int node) -> float { return (toTarget(node) - fromStart(node)) * 0.5f; };
+
+	fctx.setG(start, 0);
+	fctx.setMarked(start, true);
+	fctx.open().push(start, potential(start));
+	bctx.setG(target, 0);
+	bctx.setMarked(target, true);
+	bctx.open().push(target, -potential(target));
+
+	ArcType best = fctx.maxG();
+	meet = start == target ? start : -1;
+	if (meet != -1)
+		best = 0;
+
+	//Limits are only checked if there are any
+	SearchBudget const & budget = fctx.budget();
+	bool limited = budget.limited();
+	SearchStatus status = Complete;
+	int expansions = 0;
+	int closest = start;
+	float closestH = toTarget(start);
+
+	while (!fctx.open().empty() && !bctx.open().empty())
+	{
+		//Nothing left on either list can beat the best route
+		float bound = fctx.open().topKey() + bctx.open().topKey();
+		if (bound >= best)
+			break;
+
+		bool forwards = fctx.open().topKey() <= bctx.open().topKey();
+
+		//Stop at the first limit reached, keeping the forward node closest to the target
+		if (limited)
+		{
+			status = budget.check(expansions++, bound);
+			if (status != Complete)
+				break;
+
+			if (forwards && toTarget(fctx.open().top()) < closestH)
+			{
+				closestH = toTarget(fctx.open().top());
+				closest = fctx.open().top();
+			}
+		}
+
+		//Expand whichever side has the lower key
+		if (forwards)
+			expandSide(forward, fctx, bctx, 1.0f, potential, best, meet);
+		else expandSide(reverse, bctx, fctx, -1.0f, potential, best, meet);
+	}
+
+	//The lists never touched
+	if (status == Complete && meet == -1)
+		status = Unreachable;
+
+	//Met, but by a route dearer than allowed
+	else if (status == Complete && budget.costLimited() && (float)best > budget.maxCost)
+		status = CostLimit;
+
+	fctx.setStatus(status, !limited ? -1 : meet != -1 ? target : closest);
+	return status;
+}
+
+// ----------------------------------------------------------------
+//  Name:           joinSearches
+//  Description:    Copies the backward half of a bidirectional route
+//                  into the forward context, so its G and previous
+//                  indices read the same as after a forward search.
+//  Arguments:      The first two parameters are the forward and
+//                  backward contexts
+//                  The third is the meeting node from
+//                  bidirectionalSearch.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+void joinSearches(SearchContext<ArcType>& fctx, SearchContext<ArcType> const & bctx, int meet)
+{
+	if (meet == -1)
+		return;
+
+	ArcType total = fctx.g(meet) + bctx.g(meet);
+	for (int node = meet, next = bctx.prev(meet); next != -1; node = next, next = bctx.prev(next))
+	{
+		fctx.setG(next, total - bctx.g(next));
+		fctx.setPrev(next, node);
+		fctx.setMarked(next, true);
+	}
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef GRAPHTRACE_H
+#define GRAPHTRACE_H
+
+#include <ostream>
+#include <vector>
+
+// ----------------------------------------------------------------
+//  Tracing policies for the searches in Graph.hpp. The searches call
+//  the same events on whichever policy they are given, NullTrace's
+//  events are empty so a search instantiated with it has no tracing
+//  code left in it at all.
+//
+//  GRAPH_TRACE decides whether the node based searches can trace at
+//  all. It defaults to on for _DEBUG builds and off otherwise, in
+//  which case m_verbosity no longer affects the search loops.
+// ----------------------------------------------------------------
+#ifndef GRAPH_TRACE
+#ifdef _DEBUG
+#define GRAPH_TRACE 1
+#else
+#define GRAPH_TRACE 0
+#endif
+#endif
+
+template <class NodeType, class ArcType> class GraphNode;
+
+//Traces nothing
+struct NullTrace {
+	void pop(int) {}
+	template<class Cost> void check(int, int, Cost, Cost) {}
+	template<class Cost> void improve(int, Cost, int, bool) {}
+	template<class Cost> void keep(int, Cost, int) {}
+	void expanded(int) {}
+};
+
+//Writes the events as text, the same lines the searches used to print
+template<class NodeType, class ArcType>
+class StreamTrace {
+private:
+	std::ostream& m_out;
+	GraphNode<NodeType, ArcType>* const * m_pNodes;
+
+	NodeType const & data(int node) const { return m_pNodes[node]->data(); }
+
+public:
+	StreamTrace(std::ostream& out, GraphNode<NodeType, ArcType>* const * pNodes) : m_out(out), m_pNodes(pNodes) {}
+
+	void pop(int node)
+	{
+		m_out << "Popping: " << data(node) << std::endl;
+	}
+
+	template<class Cost>
+	void check(int from, int to, Cost cost, Cost g)
+	{
+		m_out << "\t" << "Checking: " << data(from) << " -> " << data(to) << " [" << cost << " < " << g << "]" << std::endl;
+	}
+
+	template<class Cost>
+	void improve(int node, Cost g, int prev, bool queued)
+	{
+		m_out << "\t\t" << "True, " << data(node) << " g is now " << g << ", previous is now " << data(prev) << std::endl;
+
+		if (queued)
+			m_out << "Queueing:  " << data(node) << std::endl;
+	}
+
+	template<class Cost>
+	void keep(int node, Cost g, int prev)
+	{
+		m_out << "\t\t" << "False, " << data(node) << " g remaining " << g << ", previous remains ";
+
+		if (prev != -1)
+			m_out << data(prev) << std::endl;
+		else m_out << "NULL" << std::endl;
+	}
+
+	void expanded(int)
+	{
+		m_out << std::endl;
+	}
+};
+
+//Counts search work, for measuring rather than printing
+struct CountTrace {
+	long long settled; //Nodes popped, their g is final
+	long long relaxed; //Arcs looked at
+	long long improved; //Arcs that lowered a g
+
+	CountTrace() : settled(0), relaxed(0), improved(0) {}
+
+	void pop(int) { ++settled; }
+	template<class Cost> void check(int, int, Cost, Cost) { ++relaxed; }
+	template<class Cost> void improve(int, Cost, int, bool) { ++improved; }
+	template<class Cost> void keep(int, Cost, int) {}
+	void expanded(int) {}
+};
+
+//One structured trace event
+struct TraceEvent {
+	enum Type { POP, CHECK, IMPROVE, QUEUE, KEEP, EXPANDED };
+
+	Type type;
+	int node; //Node the event is about
+	int other; //Parent for CHECK, previous for IMPROVE and KEEP, else -1
+	double cost; //Route cost for CHECK, g for IMPROVE and KEEP, else 0
+};
+
+//Records the events for later inspection
+struct RecordTrace {
+	std::vector<TraceEvent> events;
+
+	void add(TraceEvent::Type type, int node, int other, double cost)
+	{
+		TraceEvent event = { type, node, other, cost };
+		events.push_back(event);
+	}
+
+	void pop(int node) { add(TraceEvent::POP, node, -1, 0); }
+	template<class Cost> void check(int from, int to, Cost cost, Cost g) { add(TraceEvent::CHECK, to, from, cost); }
+	template<class Cost> void improve(int node, Cost g, int prev, bool queued)
+	{
+		add(TraceEvent::IMPROVE, node, prev, g);
+		if (queued)
+			add(TraceEvent::QUEUE, node, -1, 0);
+	}
+	template<class Cost> void keep(int node, Cost g, int prev) { add(TraceEvent::KEEP, node, prev, g); }
+	void expanded(int node) { add(TraceEvent::EXPANDED, node, -1, 0); }
+};
+
+#endif
@@ -0,0 +1,592 @@
+#ifndef GRIDGRAPH_H
+#define GRIDGRAPH_H
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Graph.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           GridGraph
+//  Description:    8-connected grid of uniform cost cells. Cells are
+//                  only a passable flag each, the arcs are implied by
+//                  the layout. Diagonal moves may not cut a blocked
+//                  corner. Searched with Jump Point Search, which
+//                  only expands cells where the best route can turn
+//                  (jump points) and skips the many equal cost orders
+//                  of the same moves A* would expand.
+//                  JPS+ precomputes how far each cell can jump in
+//                  each direction so a query doesn't walk the grid.
+//                  Nodes are only made for cells on returned paths,
+//                  so the paths have the same shape as Graph's.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class GridGraph {
+private:
+	typedef GraphNode<NodeType, ArcType> Node;
+
+	int m_width;
+	int m_height;
+	std::vector<char> m_passable; //Row major, one per cell
+
+	ArcType m_straight; //Cost of a move along a row or column
+	ArcType m_diagonal; //Cost of a diagonal move
+
+	//JPS+ jump distances, 8 per cell: > 0 is a jump point that many
+	//steps away, <= 0 is minus the steps before a wall. Empty until built.
+	std::vector<int> m_jumps;
+
+	//Nodes handed out for path cells, made as needed
+	std::unordered_map<int, Node*> m_nodes;
+	sf::Vector2f m_origin; //Position of cell (0, 0)
+	sf::Vector2f m_spacing; //Distance between cell positions
+
+	//Search state used by the node based searches
+	SearchContext<ArcType> m_context;
+
+	int m_verbosity;
+
+public:
+	GridGraph(int width, int height, ArcType straight, ArcType diagonal);
+	~GridGraph();
+
+	// Accessors
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int cellCount() const { return m_width * m_height; }
+	int index(int x, int y) const { return y * m_width + x; }
+	int cellX(int cell) const { return cell % m_width; }
+	int cellY(int cell) const { return cell / m_width; }
+	bool passable(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height && m_passable[index(x, y)] != 0; }
+	bool hasJumps() const { return !m_jumps.empty(); }
+	SearchContext<ArcType> & context() { return m_context; }
+	ArcType g(Node* pNode) const { return m_context.g(pNode->index()); }
+
+	// Manipulators
+	void setPassable(int x, int y, bool passable);
+	void setLayout(sf::Vector2f origin, sf::Vector2f spacing) { m_origin = origin; m_spacing = spacing; }
+	void setVerbosity(int verbosity) { m_verbosity = verbosity; }
+	void setSearchBudget(SearchBudget const & budget) { m_context.setBudget(budget); } //For the node based searches
+
+	//Node for a cell, made the first time it's asked for. Its data is (x, y) if NodeType can be built from that
+	Node* node(int x, int y);
+
+	//Precompute JPS+ jump distances, cleared whenever a cell changes
+	void genJumps();
+
+	//Searches, same path format as Graph::UCS
+	void JPS(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+	void JPSPlus(Node* pStart, Node* pTarget, std::vector<Node*>& path);
+
+	//Searches on a caller owned context, the grid is only read. The context's budget applies, see SearchBudget.hpp
+	SearchStatus JPS(SearchContext<ArcType>& ctx, int start, int target) const;
+	SearchStatus JPSPlus(SearchContext<ArcType>& ctx, int start, int target) const;
+
+	//Every cell of the route, start first, just the target if there isn't one, see Graph::getPath for limits
+	void getPath(SearchContext<ArcType> const & ctx, int target, std::vector<int>& cells) const;
+	void getPath(SearchContext<ArcType> const & ctx, int target, std::vector<Node*>& path);
+
+private:
+	static int dirX(int dir) { static const int x[8] = { 1, 1, 0, -1, -1, -1, 0, 1 }; return x[dir]; }
+	static int dirY(int dir) { static const int y[8] = { 0, 1, 1, 1, 0, -1, -1, -1 }; return y[dir]; }
+	static int direction(int dx, int dy);
+	static int sign(int v) { return (v > 0) - (v < 0); }
+	static NodeType cellData(int x, int y, std::true_type) { return NodeType(x, y); }
+	static NodeType cellData(int, int, std::false_type) { return NodeType(); }
+
+	ArcType octile(int from, int to) const;
+	bool canMove(int x, int y, int dx, int dy) const;
+	bool forced(int x, int y, int dx, int dy) const;
+	int successors(int cell, int parent, int* dirs) const;
+
+	int jump(int x, int y, int dx, int dy, int target) const;
+	int jumpPlus(int cell, int dir, int target) const;
+
+	template<bool Plus>
+	SearchStatus search(SearchContext<ArcType>& ctx, int start, int target) const;
+	template<bool Plus>
+	void timedSearch(char const * name, Node* pStart, Node* pTarget, std::vector<Node*>& path);
+};
+
+template<class NodeType, class ArcType>
+GridGraph<NodeType, ArcType>::GridGraph(int width, int height, ArcType straight, ArcType diagonal) :
+	m_width(width), m_height(height), m_passable((size_t)width * height, 1),
+	m_straight(straight), m_diagonal(diagonal), m_spacing(1, 1), m_context(width * height), m_verbosity(1)
+{
+}
+
+template<class NodeType, class ArcType>
+GridGraph<NodeType, ArcType>::~GridGraph()
+{
+	for (typename std::unordered_map<int, Node*>::iterator iter = m_nodes.begin(); iter != m_nodes.end(); ++iter)
+		delete iter->second;
+}
+
+template<class NodeType, class ArcType>
+void GridGraph<NodeType, ArcType>::setPassable(int x, int y, bool passable)
+{
+	m_passable[index(x, y)] = passable;
+
+	//Jump distances were for the old cells
+	m_jumps.clear();
+}
+
+template<class NodeType, class ArcType>
+GraphNode<NodeType, ArcType>* GridGraph<NodeType, ArcType>::node(int x, int y)
+{
+	int cell = index(x, y);
+
+	typename std::unordered_map<int, Node*>::iterator iter = m_nodes.find(cell);
+	if (iter != m_nodes.end())
+		return iter->second;
+
+	Node* pNode = new Node();
+	pNode->setData(cellData(x, y, std::is_constructible<NodeType, int, int>()));
+	pNode->setIndex(cell);
+	pNode->setPosition(sf::Vector2f(m_origin.x + x * m_spacing.x, m_origin.y + y * m_spacing.y));
+	m_nodes[cell] = pNode;
+	return pNode;
+}
+
+template<class NodeType, class ArcType>
+int GridGraph<NodeType, ArcType>::direction(int dx, int dy)
+{
+	for (int dir = 0; dir < 8; ++dir)
+	{
+		if (dirX(dir) == dx && dirY(dir) == dy)
+			return dir;
+	}
+
+	return -1;
+}
+
+//Cost of the cheapest unblocked route between two cells
+template<class NodeType, class ArcType>
+ArcType GridGraph<NodeType, ArcType>::octile(int from, int to) const
+{
+	int dx = cellX(to) - cellX(from);
+	int dy = cellY(to) - cellY(from);
+	if (dx < 0) dx = -dx;
+	if (dy < 0) dy = -dy;
+
+	return dx < dy ? m_diagonal * dx + m_straight * (dy - dx) : m_diagonal * dy + m_straight * (dx - dy);
+}
+
+//Diagonals need both cells beside them free
+template<class NodeType, class ArcType>
+bool GridGraph<NodeType, ArcType>::canMove(int x, int y, int dx, int dy) const
+{
+	if (!passable(x + dx, y + dy))
+		return false;
+
+	return dx == 0 || dy == 0 || (passable(x + dx, y) && passable(x, y + dy));
+}
+
+//A straight move reaching x, y has a neighbour it can't be pruned past
+template<class NodeType, class ArcType>
+bool GridGraph<NodeType, ArcType>::forced(int x, int y, int dx, int dy) const
+{
+	if (dx != 0)
+		return (passable(x, y - 1) && !passable(x - dx, y - 1)) || (passable(x, y + 1) && !passable(x - dx, y + 1));
+
+	return (passable(x - 1, y) && !passable(x - 1, y - dy)) || (passable(x + 1, y) && !passable(x + 1, y - dy));
+}
+
+// ----------------------------------------------------------------
+//  Name:           successors
+//  Description:    Directions worth jumping in from a cell, given the
+//                  direction it was reached in. A diagonal only goes
+//                  on along itself and its two straight parts, a
+//                  straight move goes on and only turns (straight or
+//                  diagonally) towards a side whose cell behind it is
+//                  blocked, the forced neighbours of forced().
+//  Arguments:      The first parameter is the cell
+//                  The second is the cell it was reached from, -1 for
+//                  the start
+//                  The third receives up to 8 directions.
+//  Return Value:   Number of directions.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int GridGraph<NodeType, ArcType>::successors(int cell, int parent, int* dirs) const
+{
+	int x = cellX(cell);
+	int y = cellY(cell);
+	int count = 0;
+
+	//Start can go anywhere
+	if (parent == -1)
+	{
+		for (int dir = 0; dir < 8; ++dir)
+		{
+			if (canMove(x, y, dirX(dir), dirY(dir)))
+				dirs[count++] = dir;
+		}
+		return count;
+	}
+
+	int dx = sign(x - cellX(parent));
+	int dy = sign(y - cellY(parent));
+
+	if (dx != 0 && dy != 0)
+	{
+		if (passable(x, y + dy))
+			dirs[count++] = direction(0, dy);
+		if (passable(x + dx, y))
+			dirs[count++] = direction(dx, 0);
+		if (canMove(x, y, dx, dy))
+			dirs[count++] = direction(dx, dy);
+	}
+
+	else
+	{
+		if (passable(x + dx, y + dy))
+			dirs[count++] = direction(dx, dy);
+
+		//Each side turns only where the cell behind it is blocked, else the parent reaches it as cheaply
+		for (int side = -1; side <= 1; side += 2)
+		{
+			int px = dx == 0 ? side : 0;
+			int py = dy == 0 ? side : 0;
+
+			if (!passable(x + px, y + py) || passable(x - dx + px, y - dy + py))
+				continue;
+
+			dirs[count++] = direction(px, py);
+			if (canMove(x, y, dx + px, dy + py))
+				dirs[count++] = direction(dx + px, dy + py);
+		}
+	}
+
+	return count;
+}
+
+// ----------------------------------------------------------------
+//  Name:           jump
+//  Description:    Walks from a cell in one direction until it finds
+//                  the target, a forced neighbour, or for diagonals a
+//                  cell whose straight parts find one.
+//  Arguments:      The first two parameters are the cell to walk from
+//                  The next two are the direction
+//                  The last is the target cell.
+//  Return Value:   The jump point, -1 if a wall came first.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int GridGraph<NodeType, ArcType>::jump(int x, int y, int dx, int dy, int target) const
+{
+	for (;;)
+	{
+		x += dx;
+		y += dy;
+
+		if (!passable(x, y))
+			return -1;
+
+		int cell = index(x, y);
+		if (cell == target)
+			return cell;
+
+		if (dx != 0 && dy != 0)
+		{
+			if (jump(x, y, dx, 0, target) != -1 || jump(x, y, 0, dy, target) != -1)
+				return cell;
+
+			//Corner cut
+			if (!passable(x + dx, y) || !passable(x, y + dy))
+				return -1;
+		}
+
+		else if (forced(x, y, dx, dy))
+			return cell;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           genJumps
+//  Description:    Fills in the JPS+ jump distances. Each direction is
+//                  swept from the far side so a cell's next cell is
+//                  always done first, straight directions before the
+//                  diagonals that look along them.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void GridGraph<NodeType, ArcType>::genJumps()
+{
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
+
+	m_jumps.assign((size_t)cellCount() * 8, 0);
+
+	//Straight (even) directions, then diagonal (odd)
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int dir = pass; dir < 8; dir += 2)
+		{
+			int dx = dirX(dir);
+			int dy = dirY(dir);
+
+			for (int row = 0; row < m_height; ++row)
+			{
+				int y = dy > 0 ? m_height - 1 - row : row;
+
+				for (int column = 0; column < m_width; ++column)
+				{
+					int x = dx > 0 ? m_width - 1 - column : column;
+
+					if (!passable(x, y) || !canMove(x, y, dx, dy))
+						continue;
+
+					int next = index(x + dx, y + dy);
+					int& jumpTo = m_jumps[(size_t)index(x, y) * 8 + dir];
+
+					bool stop = dx != 0 && dy != 0
+						? m_jumps[(size_t)next * 8 + direction(dx, 0)] > 0 || m_jumps[(size_t)next * 8 + direction(0, dy)] > 0
+						: forced(x + dx, y + dy, dx, dy);
+
+					int onward = m_jumps[(size_t)next * 8 + dir];
+					jumpTo = stop ? 1 : (onward > 0 ? onward + 1 : onward - 1);
+				}
+			}
+		}
+	}
+
+	//Stop timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
+
+	if (m_verbosity >= 1)
+		std::cout << "Jump distances generated. (" << elapsed_seconds.count() << "s)" << std::endl;
+}
+
+// ----------------------------------------------------------------
+//  Name:           jumpPlus
+//  Description:    JPS+ version of jump, reads the jump distance and
+//                  only checks whether the target comes first. On a
+//                  diagonal that means stopping level with the target
+//                  so the straight jump from there can reach it.
+//  Arguments:      The first parameter is the cell to jump from
+//                  The second is the direction
+//                  The third is the target cell.
+//  Return Value:   The jump point, -1 if a wall came first.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int GridGraph<NodeType, ArcType>::jumpPlus(int cell, int dir, int target) const
+{
+	int dx = dirX(dir);
+	int dy = dirY(dir);
+	int jumpTo = m_jumps[(size_t)cell * 8 + dir];
+	int steps = jumpTo > 0 ? jumpTo : -jumpTo;
+
+	int tx = cellX(target) - cellX(cell);
+	int ty = cellY(target) - cellY(cell);
+
+	if (dx == 0 || dy == 0)
+	{
+		//Target on this row or column, ahead and within reach
+		int ahead = dx != 0 ? tx * dx : ty * dy;
+		if ((dx != 0 ? ty == 0 : tx == 0) && ahead > 0 && ahead <= steps)
+			return target;
+	}
+
+	else if (sign(tx) == dx && sign(ty) == dy)
+	{
+		//Target in this quadrant, stop level with it if that's in reach
+		int level = tx * dx < ty * dy ? tx * dx : ty * dy;
+		if (level <= steps)
+			return cell + level * (dy * m_width + dx);
+	}
+
+	return jumpTo > 0 ? cell + jumpTo * (dy * m_width + dx) : -1;
+}
+
+// ----------------------------------------------------------------
+//  Name:           search
+//  Description:    A* over jump points with the octile distance as H.
+//                  The previous index of each jump point is the one it
+//                  was jumped to from, getPath fills in the cells.
+//  Arguments:      The first parameter is the context to search with
+//                  The second and third are the start and target cells.
+//                  The context's budget can stop the search early,
+//                  each jump point popped counts as one expansion.
+//  Return Value:   How the search ended, also left in the context
+//                  along with the results.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<bool Plus>
+SearchStatus GridGraph<NodeType, ArcType>::search(SearchContext<ArcType>& ctx, int start, int target) const
+{
+	if (ctx.size() < cellCount())
+		ctx.resize(cellCount());
+	ctx.reset();
+	ctx.setG(start, 0);
+	ctx.setMarked(start, true);
+
+	IndexedHeap<float>& open = ctx.open();
+	open.push(start, (float)octile(start, target));
+
+	//Limits are only checked if there are any
+	SearchBudget const & budget = ctx.budget();
+	bool limited = budget.limited();
+	SearchStatus status = Complete;
+	int expansions = 0;
+	int closest = start;
+	ArcType closestH = octile(start, target);
+
+	int dirs[8];
+	while (!open.empty() && open.top() != target)
+	{
+		//Stop at the first limit reached, keeping the closest jump point so far
+		if (limited)
+		{
+			status = budget.check(expansions++, (float)ctx.g(open.top()));
+			if (status != Complete)
+				break;
+
+			if (octile(open.top(), target) < closestH)
+			{
+				closestH = octile(open.top(), target);
+				closest = open.top();
+			}
+		}
+
+		int top = open.pop();
+		int count = successors(top, ctx.prev(top), dirs);
+
+		for (int i = 0; i < count; ++i)
+		{
+			int child = Plus ? jumpPlus(top, dirs[i], target) : jump(cellX(top), cellY(top), dirX(dirs[i]), dirY(dirs[i]), target);
+			if (child == -1 || ctx.closed(child))
+				continue;
+
+			ArcType gn = ctx.g(top) + octile(top, child);
+			if (gn < ctx.g(child))
+			{
+				ctx.setG(child, gn);
+				ctx.setPrev(child, top);
+				open.pushOrDecrease(child, gn + octile(child, target));
+				ctx.setMarked(child, true);
+			}
+		}
+	}
+
+	//Nothing left to search and the target never came up
+	if (status == Complete && open.empty())
+		status = Unreachable;
+
+	//Reached the target, but by a route dearer than allowed
+	else if (status == Complete && !open.empty() && budget.costLimited() && (float)ctx.g(target) > budget.maxCost)
+		status = CostLimit;
+
+	ctx.setStatus(status, limited ? closest : -1);
+	return status;
+}
+
+template<class NodeType, class ArcType>
+SearchStatus GridGraph<NodeType, ArcType>::JPS(SearchContext<ArcType>& ctx, int start, int target) const
+{
+	return search<false>(ctx, start, target);
+}
+
+//Jump distances must have been built, see genJumps
+template<class NodeType, class ArcType>
+SearchStatus GridGraph<NodeType, ArcType>::JPSPlus(SearchContext<ArcType>& ctx, int start, int target) const
+{
+	return search<true>(ctx, start, target);
+}
+
+template<class NodeType, class ArcType>
+void GridGraph<NodeType, ArcType>::JPS(Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	timedSearch<false>("JPS", pStart, pTarget, path);
+}
+
+template<class NodeType, class ArcType>
+void GridGraph<NodeType, ArcType>::JPSPlus(Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	if (m_jumps.empty())
+		genJumps();
+
+	timedSearch<true>("JPS+", pStart, pTarget, path);
+}
+
+template<class NodeType, class ArcType>
+template<bool Plus>
+void GridGraph<NodeType, ArcType>::timedSearch(char const * name, Node* pStart, Node* pTarget, std::vector<Node*>& path)
+{
+	//Start timer
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	start = std::chrono::system_clock::now();
+
+	search<Plus>(m_context, pStart->index(), pTarget->index());
+
+	//End timer
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> elapsed_seconds = end - start;
+
+	if (m_verbosity >= 1)
+	{
+		std::cout << "=== " << name << " from (" << cellX(pStart->index()) << ", " << cellY(pStart->index()) << ") to ("
+			<< cellX(pTarget->index()) << ", " << cellY(pTarget->index()) << ") complete. (" << elapsed_seconds.count() << "s)===" << std::endl << std::endl;
+	}
+
+	//Add the nodes to path
+	getPath(m_context, pTarget->index(), path);
+}
+
+// ----------------------------------------------------------------
+//  Name:           getPath
+//  Description:    Follows the jump points back from the target and
+//                  fills in the straight or diagonal run of cells
+//                  between each pair. If a limit stopped the search
+//                  it's to the closest jump point when the budget asked
+//                  for a partial path, else empty.
+//  Arguments:      The first parameter is the searched context
+//                  The second is the target cell
+//                  The third is the path to fill.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void GridGraph<NodeType, ArcType>::getPath(SearchContext<ArcType> const & ctx, int target, std::vector<int>& cells) const
+{
+	cells.clear();
+
+	//Stopped by a limit, the statuses after Unreachable
+	if (ctx.status() > Unreachable)
+	{
+		if (!ctx.budget().partialPath || ctx.closest() == -1)
+			return;
+
+		target = ctx.closest();
+	}
+
+	int cell = target;
+	while (ctx.prev(cell) != -1)
+	{
+		int prev = ctx.prev(cell);
+		int step = sign(cellY(prev) - cellY(cell)) * m_width + sign(cellX(prev) - cellX(cell));
+
+		for (; cell != prev; cell += step)
+			cells.push_back(cell);
+	}
+	cells.push_back(cell);
+
+	std::reverse(cells.begin(), cells.end());
+}
+
+template<class NodeType, class ArcType>
+void GridGraph<NodeType, ArcType>::getPath(SearchContext<ArcType> const & ctx, int target, std::vector<Node*>& path)
+{
+	std::vector<int> cells;
+	getPath(ctx, target, cells);
+
+	path.clear();
+	for (int i = 0, c = (int)cells.size(); i < c; ++i)
+		path.push_back(node(cellX(cells[i]), cellY(cells[i])));
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef HEURISTICS_H
+#define HEURISTICS_H
+
+#include "DistanceKernels.hpp"
+#include "SearchContext.hpp"
+
+// ----------------------------------------------------------------
+//  Heuristics for Graph::AStar. Each one is a small functor that
+//  returns the estimated cost from a node index to the target, and
+//  is only asked about nodes the search actually reaches.
+// ----------------------------------------------------------------
+
+//No estimate, turns A* into UCS
+struct ZeroHeuristic {
+	float operator()(int) const { return 0; }
+};
+
+//H values already filled into a context (InitAStar, mapNodes)
+template<class ArcType>
+struct StoredHeuristic {
+	SearchContext<ArcType> const * pCtx;
+
+	explicit StoredHeuristic(SearchContext<ArcType> const & ctx) : pCtx(&ctx) {}
+	float operator()(int node) const { return pCtx->h(node); }
+};
+
+//Distance to the target from node positions kept as flat x and y arrays,
+//see DistanceKernels.hpp. Also gives H for a whole batch of nodes, which
+//aStarSearchBatched uses.
+struct PositionHeuristic {
+	float const * xs;
+	float const * ys;
+	float tx, ty;
+	Distance distance;
+
+	PositionHeuristic(float const * xs, float const * ys, int target, Distance distance = Distance()) :
+		xs(xs), ys(ys), tx(xs[target]), ty(ys[target]), distance(distance) {}
+
+	float operator()(int node) const { return distance(xs[node] - tx, ys[node] - ty); }
+	void operator()(int const * nodes, int count, float* out) const { distances(distance, tx, ty, xs, ys, nodes, count, out); }
+};
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef IMPLICITGRID_H
+#define IMPLICITGRID_H
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "DistanceKernels.hpp"
+#include "SearchContext.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           ImplicitGrid
+//  Description:    Grid graph with no nodes or arcs stored at all.
+//                  Passability is one bit per cell and the optional
+//                  cost of entering a cell is one byte, everything
+//                  else is worked out when asked for.
+//                  It has the same adjacency interface as GraphCSR
+//                  (nodeCount, begin, end, target, weight), so the
+//                  index based searches run on it. Arc ids are
+//                  cell * 8 + dir, straight directions first so a
+//                  4-connected grid just stops early. Impassable cells
+//                  have no arcs at all. A blocked arc out of a
+//                  passable cell targets its own cell, which the
+//                  searches skip as already closed.
+//                  An arc charges the cost of the cell it enters, so
+//                  once costs are set the grid is no longer its own
+//                  reverse. bidirectionalSearch and LandmarkTable need
+//                  reversed() as their reverse adjacency then, a view
+//                  of the same cells rather than a copy.
+// ----------------------------------------------------------------
+template<class ArcType> class ReversedGrid;
+
+template<class ArcType>
+class ImplicitGrid {
+private:
+	int m_width;
+	int m_height;
+	int m_directions; //4 or 8
+	std::vector<unsigned> m_passable; //One bit per cell, row major
+	std::vector<unsigned char> m_cost; //Cost of entering each cell, empty for all 1
+
+	ArcType m_straight; //Base cost of a move along a row or column
+	ArcType m_diagonal; //Base cost of a diagonal move
+
+	static int dirX(int dir) { static const int x[8] = { 1, 0, -1, 0, 1, -1, -1, 1 }; return x[dir]; }
+	static int dirY(int dir) { static const int y[8] = { 0, 1, 0, -1, 1, 1, -1, -1 }; return y[dir]; }
+
+public:
+	ImplicitGrid() : m_width(0), m_height(0), m_directions(8), m_straight(1), m_diagonal(1) {}
+	ImplicitGrid(int width, int height, ArcType straight, ArcType diagonal, int directions = 8) { resize(width, height, straight, diagonal, directions); }
+
+	//All cells passable at cost 1
+	void resize(int width, int height, ArcType straight, ArcType diagonal, int directions = 8);
+
+	//Load a MovingAI .map file, '.', 'G' and 'S' are passable, keeps the move costs and directions
+	bool load(std::string const & filename);
+
+	// Accessors
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int index(int x, int y) const { return y * m_width + x; }
+	int cellX(int cell) const { return cell % m_width; }
+	int cellY(int cell) const { return cell / m_width; }
+	bool passable(int cell) const { return (m_passable[cell >> 5] >> (cell & 31) & 1) != 0; }
+	bool passable(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height && passable(index(x, y)); }
+	int cost(int cell) const { return m_cost.empty() ? 1 : m_cost[cell]; }
+	int directions() const { return m_directions; }
+	ArcType straightCost() const { return m_straight; }
+	ArcType diagonalCost() const { return m_diagonal; }
+	size_t memoryUsed() const { return m_passable.size() * sizeof(unsigned) + m_cost.size(); }
+
+	// Manipulators
+	void setPassable(int x, int y, bool passable);
+	void setCost(int x, int y, unsigned char cost);
+
+	//Every arc turned around, reads this grid so it mustn't outlive it
+	ReversedGrid<ArcType> reversed() const { return ReversedGrid<ArcType>(*this); }
+
+	// Adjacency, see GraphCSR
+	int nodeCount() const { return m_width * m_height; }
+	int begin(int node) const { return node * 8; }
+	int end(int node) const { return passable(node) ? node * 8 + m_directions : node * 8; }
+	int target(int arc) const;
+	ArcType weight(int arc) const;
+
+	//Weight of the same arc turned around, it charges the cell it leaves
+	ArcType reverseWeight(int arc) const;
+
+	//Every cell of the route, start first, just the target if there isn't one
+	void getPath(SearchContext<ArcType> const & ctx, int target, std::vector<int>& cells) const;
+};
+
+//Octile (or Manhattan when 4-connected) distance to a target cell, admissible while every cell costs at least 1
+template<class ArcType>
+struct GridHeuristic {
+	ImplicitGrid<ArcType> const * pGrid;
+	float tx, ty;
+	Distance distance;
+
+	GridHeuristic(ImplicitGrid<ArcType> const & grid, int target) :
+		pGrid(&grid), tx((float)grid.cellX(target)), ty((float)grid.cellY(target)),
+		distance(grid.directions() == 8 ? Octile : Manhattan, (float)grid.straightCost(), (float)grid.diagonalCost()) {}
+
+	float operator()(int node) const { return distance(pGrid->cellX(node) - tx, pGrid->cellY(node) - ty); }
+
+	//H of count cells at once, coordinates are unpacked then run through the SIMD kernel
+	void operator()(int const * nodes, int count, float* out) const
+	{
+		const int chunk = 16;
+		float xs[chunk], ys[chunk];
+
+		for (int i = 0; i < count; i += chunk)
+		{
+			int n = count - i < chunk ? count - i : chunk;
+			for (int k = 0; k < n; ++k)
+			{
+				xs[k] = (float)pGrid->cellX(nodes[i + k]);
+				ys[k] = (float)pGrid->cellY(nodes[i + k]);
+			}
+
+			distances(distance, tx, ty, xs, ys, 0, n, out + i);
+		}
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           ReversedGrid
+//  Description:    An ImplicitGrid with every arc turned around.
+//                  Passability and corner cutting are the same both
+//                  ways, so only the weights differ: each arc charges
+//                  the cell it leaves, which is the cell the matching
+//                  forward arc enters. Holds just a pointer to the
+//                  grid, nothing is copied.
+// ----------------------------------------------------------------
+template<class ArcType>
+class ReversedGrid {
+private:
+	ImplicitGrid<ArcType> const * m_pGrid;
+
+public:
+	explicit ReversedGrid(ImplicitGrid<ArcType> const & grid) : m_pGrid(&grid) {}
+
+	ImplicitGrid<ArcType> const & grid() const { return *m_pGrid; }
+
+	// Adjacency, see GraphCSR
+	int nodeCount() const { return m_pGrid->nodeCount(); }
+	int begin(int node) const { return m_pGrid->begin(node); }
+	int end(int node) const { return m_pGrid->end(node); }
+	int target(int arc) const { return m_pGrid->target(arc); }
+	ArcType weight(int arc) const { return m_pGrid->reverseWeight(arc); }
+};
+
+template<class ArcType>
+void ImplicitGrid<ArcType>::resize(int width, int height, ArcType straight, ArcType diagonal, int directions)
+{
+	m_width = width;
+	m_height = height;
+	m_directions = directions;
+	m_straight = straight;
+	m_diagonal = diagonal;
+
+	//Whole words set, the bits past the last cell are never read
+	m_passable.assign(((size_t)width * height + 31) / 32, ~0u);
+	m_cost.clear();
+}
+
+template<class ArcType>
+void ImplicitGrid<ArcType>::setPassable(int x, int y, bool passable)
+{
+	int cell = index(x, y);
+
+	if (passable)
+		m_passable[cell >> 5] |= 1u << (cell & 31);
+	else m_passable[cell >> 5] &= ~(1u << (cell & 31));
+}
+
+//A cost of 0 blocks the cell
+template<class ArcType>
+void ImplicitGrid<ArcType>::setCost(int x, int y, unsigned char cost)
+{
+	if (m_cost.empty())
+		m_cost.assign((size_t)m_width * m_height, 1);
+
+	m_cost[index(x, y)] = cost;
+	setPassable(x, y, cost != 0);
+}
+
+// ----------------------------------------------------------------
+//  Name:           load
+//  Description:    Reads a MovingAI benchmark map: a header of type,
+//                  height and width lines, a "map" line, then one row
+//                  of characters per line. Each row is packed straight
+//                  into the bitset, so there is nothing to build.
+//  Arguments:      The file to read.
+//  Return Value:   False if the file couldn't be read.
+// ----------------------------------------------------------------
+template<class ArcType>
+bool ImplicitGrid<ArcType>::load(std::string const & filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+		return false;
+
+	std::string word;
+	int width = 0, height = 0;
+	while (file >> word && word != "map")
+	{
+		if (word == "height")
+			file >> height;
+		else if (word == "width")
+			file >> width;
+		else std::getline(file, word);
+	}
+
+	if (width <= 0 || height <= 0)
+		return false;
+
+	resize(width, height, m_straight, m_diagonal, m_directions);
+
+	std::string row;
+	std::getline(file, row);
+	for (int y = 0; y < height && std::getline(file, row); ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			char c = x < (int)row.size() ? row[x] : '@';
+			if (c != '.' && c != 'G' && c != 'S')
+				setPassable(x, y, false);
+		}
+	}
+
+	return true;
+}
+
+template<class ArcType>
+int ImplicitGrid<ArcType>::target(int arc) const
+{
+	int cell = arc >> 3;
+	int dir = arc & 7;
+	int x = cellX(cell);
+	int y = cellY(cell);
+	int nx = x + dirX(dir);
+	int ny = y + dirY(dir);
+
+	//Blocked, or a diagonal cutting a blocked corner
+	if (!passable(nx, ny) || (dir >= 4 && (!passable(nx, y) || !passable(x, ny))))
+		return cell;
+
+	return index(nx, ny);
+}
+
+template<class ArcType>
+ArcType ImplicitGrid<ArcType>::weight(int arc) const
+{
+	ArcType base = (arc & 7) < 4 ? m_straight : m_diagonal;
+
+	if (m_cost.empty())
+		return base;
+
+	return base * cost(target(arc));
+}
+
+template<class ArcType>
+ArcType ImplicitGrid<ArcType>::reverseWeight(int arc) const
+{
+	ArcType base = (arc & 7) < 4 ? m_straight : m_diagonal;
+
+	if (m_cost.empty())
+		return base;
+
+	return base * cost(arc >> 3);
+}
+
+template<class ArcType>
+void ImplicitGrid<ArcType>::getPath(SearchContext<ArcType> const & ctx, int target, std::vector<int>& cells) const
+{
+	cells.clear();
+	while (ctx.prev(target) != -1)
+	{
+		cells.push_back(target);
+		target = ctx.prev(target);
+	}
+	cells.push_back(target);
+
+	std::reverse(cells.begin(), cells.end());
+}
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+
+#include <vector>
+
+// ----------------------------------------------------------------
+//  Name:           IndexedHeap
+//  Description:    Min d-ary heap of node indices with decrease-key.
+//                  Every index remembers its slot in the heap, so a
+//                  node already on the open list can have its key
+//                  lowered in O(log n) instead of being pushed twice
+//                  or forcing a full make_heap.
+//  Arguments:      KeyType is the priority (lowest comes out first)
+//                  Arity is the number of children per heap slot.
+// ----------------------------------------------------------------
+template<class KeyType, int Arity = 4>
+class IndexedHeap {
+private:
+	struct Entry {
+		KeyType key;
+		int id;
+	};
+
+	std::vector<Entry> m_heap; //Heap ordered entries
+	std::vector<int> m_slot; //Slot of each id in m_heap, -1 when not queued
+
+	void siftUp(int slot);
+	void siftDown(int slot);
+	void place(int slot, Entry const & entry) { m_heap[slot] = entry; m_slot[entry.id] = slot; }
+
+public:
+	IndexedHeap() {}
+	explicit IndexedHeap(int capacity) { resize(capacity); }
+
+	//Number of ids that can be queued, ids are [0, capacity)
+	void resize(int capacity) { clear(); m_slot.assign(capacity, -1); }
+	int capacity() const { return (int)m_slot.size(); }
+
+	// Accessors
+	bool empty() const { return m_heap.empty(); }
+	int size() const { return (int)m_heap.size(); }
+	int top() const { return m_heap[0].id; }
+	KeyType const & topKey() const { return m_heap[0].key; }
+	bool contains(int id) const { return m_slot[id] != -1; }
+	KeyType const & key(int id) const { return m_heap[m_slot[id]].key; }
+
+	// Manipulators
+	void push(int id, KeyType key);
+	void decreaseKey(int id, KeyType key);
+	bool pushOrDecrease(int id, KeyType key);
+	void update(int id, KeyType key);
+	void remove(int id);
+	int pop();
+	void clear();
+};
+
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::siftUp(int slot)
+{
+	Entry entry = m_heap[slot];
+
+	//Move parents down until the entry's spot is found
+	while (slot > 0)
+	{
+		int parent = (slot - 1) / Arity;
+
+		if (!(entry.key < m_heap[parent].key))
+			break;
+
+		place(slot, m_heap[parent]);
+		slot = parent;
+	}
+
+	place(slot, entry);
+}
+
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::siftDown(int slot)
+{
+	Entry entry = m_heap[slot];
+	int count = (int)m_heap.size();
+
+	//Move the smallest child up until the entry's spot is found
+	for (;;)
+	{
+		int first = slot * Arity + 1;
+
+		if (first >= count)
+			break;
+
+		int last = first + Arity < count ? first + Arity : count;
+		int best = first;
+
+		for (int child = first + 1; child < last; ++child)
+		{
+			if (m_heap[child].key < m_heap[best].key)
+				best = child;
+		}
+
+		if (!(m_heap[best].key < entry.key))
+			break;
+
+		place(slot, m_heap[best]);
+		slot = best;
+	}
+
+	place(slot, entry);
+}
+
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::push(int id, KeyType key)
+{
+	Entry entry = { key, id };
+	m_heap.push_back(entry);
+	siftUp((int)m_heap.size() - 1);
+}
+
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::decreaseKey(int id, KeyType key)
+{
+	int slot = m_slot[id];
+	m_heap[slot].key = key;
+	siftUp(slot);
+}
+
+//Changes a queued id's key up or down
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::update(int id, KeyType key)
+{
+	int slot = m_slot[id];
+	m_heap[slot].key = key;
+	siftUp(slot);
+	siftDown(m_slot[id]);
+}
+
+//Takes a queued id off the heap wherever it is
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::remove(int id)
+{
+	int slot = m_slot[id];
+	m_slot[id] = -1;
+
+	//Fill the hole with the last entry, which may need to go either way
+	Entry last = m_heap.back();
+	m_heap.pop_back();
+
+	if (slot < (int)m_heap.size())
+	{
+		m_heap[slot] = last;
+		siftUp(slot);
+		siftDown(m_slot[last.id]);
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           pushOrDecrease
+//  Description:    Queues the id, or lowers its key if it is already
+//                  queued with a higher one.
+//  Return Value:   True if the id was queued or its key changed.
+// ----------------------------------------------------------------
+template<class KeyType, int Arity>
+bool IndexedHeap<KeyType, Arity>::pushOrDecrease(int id, KeyType key)
+{
+	if (!contains(id))
+	{
+		push(id, key);
+		return true;
+	}
+
+	if (key < m_heap[m_slot[id]].key)
+	{
+		decreaseKey(id, key);
+		return true;
+	}
+
+	return false;
+}
+
+template<class KeyType, int Arity>
+int IndexedHeap<KeyType, Arity>::pop()
+{
+	int id = m_heap[0].id;
+	m_slot[id] = -1;
+
+	//Move the last entry to the root and let it sink
+	Entry last = m_heap.back();
+	m_heap.pop_back();
+
+	if (!m_heap.empty())
+	{
+		m_heap[0] = last;
+		siftDown(0);
+	}
+
+	return id;
+}
+
+template<class KeyType, int Arity>
+void IndexedHeap<KeyType, Arity>::clear()
+{
+	//Only queued ids have a slot to forget
+	for (int i = 0, c = (int)m_heap.size(); i < c; ++i)
+	{
+		m_slot[m_heap[i].id] = -1;
+	}
+
+	m_heap.clear();
+}
+
+#endif
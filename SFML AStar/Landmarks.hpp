@@ -0,0 +1,204 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <vector>
+
+#include "GraphSearch.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           LandmarkTable
+//  Description:    ALT (A*, landmarks, triangle inequality) heuristic
+//                  data. A few landmark nodes are picked far apart and
+//                  the exact cost to and from each of them is stored
+//                  for every node. For any landmark L the triangle
+//                  inequality gives
+//                      d(v, t) >= d(L, t) - d(L, v)
+//                      d(v, t) >= d(v, L) - d(t, L)
+//                  and the largest of these is an admissible H.
+// ----------------------------------------------------------------
+template<class ArcType>
+class LandmarkTable {
+private:
+	int m_nodes; //Node slots covered
+	int m_count; //Landmarks per node
+	std::vector<int> m_landmarks; //Node index of each landmark
+	std::vector<ArcType> m_from; //d(landmark, node), the node's landmarks are side by side
+	std::vector<ArcType> m_to; //d(node, landmark), same layout
+	ArcType m_unreached; //Stored when a landmark and node aren't connected
+
+public:
+	LandmarkTable() : m_nodes(0), m_count(0), m_unreached(0) {}
+
+	// Accessors
+	bool empty() const { return m_count == 0; }
+	int count() const { return m_count; }
+	int nodeCount() const { return m_nodes; }
+	int landmark(int i) const { return m_landmarks[i]; }
+
+	void clear();
+
+	//Pick up to count landmarks and fill in the distances
+	template<class Forward, class Reverse>
+	void build(Forward const & forward, Reverse const & reverse, int count);
+
+	//Lower bound on the cost from node to target
+	float estimate(int node, int target) const;
+};
+
+//Heuristic functor for aStarSearch, see Heuristics.hpp
+template<class ArcType>
+struct LandmarkHeuristic {
+	LandmarkTable<ArcType> const * pTable;
+	int target;
+
+	LandmarkHeuristic(LandmarkTable<ArcType> const & table, int target) : pTable(&table), target(target) {}
+	float operator()(int node) const { return pTable->estimate(node, target); }
+};
+
+//Estimate from a source to each node, for the backward side of a bidirectional search
+template<class ArcType>
+struct LandmarkSourceHeuristic {
+	LandmarkTable<ArcType> const * pTable;
+	int source;
+
+	LandmarkSourceHeuristic(LandmarkTable<ArcType> const & table, int source) : pTable(&table), source(source) {}
+	float operator()(int node) const { return pTable->estimate(source, node); }
+};
+
+template<class ArcType>
+void LandmarkTable<ArcType>::clear()
+{
+	m_nodes = 0;
+	m_count = 0;
+	m_landmarks.clear();
+	m_from.clear();
+	m_to.clear();
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Picks landmarks by farthest point selection, each
+//                  new landmark is the node furthest from all the ones
+//                  already picked (nodes no landmark reaches count as
+//                  furthest, so every component gets one). Runs a
+//                  full UCS out of and into each landmark.
+//  Arguments:      The first parameter is the forward adjacency
+//                  The second is the same adjacency turned around
+//                  The third is the number of landmarks wanted.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+template<class Forward, class Reverse>
+void LandmarkTable<ArcType>::build(Forward const & forward, Reverse const & reverse, int count)
+{
+	clear();
+
+	int nodes = forward.nodeCount();
+	SearchContext<ArcType> ctx(nodes);
+	m_unreached = ctx.maxG();
+
+	//Rows of distances per landmark, interleaved per node at the end
+	std::vector<std::vector<ArcType>> fromRows;
+	std::vector<std::vector<ArcType>> toRows;
+
+	//Distance from each node to its nearest landmark so far
+	std::vector<ArcType> nearest(nodes, m_unreached);
+
+	//Start from the node furthest from the first node with any arcs
+	int seed = -1;
+	for (int n = 0; n < nodes && seed == -1; ++n)
+	{
+		if (forward.begin(n) != forward.end(n) || reverse.begin(n) != reverse.end(n))
+			seed = n;
+	}
+
+	if (seed == -1)
+		return;
+
+	aStarSearch(forward, ctx, seed, -1, ZeroHeuristic());
+	for (int n = 0; n < nodes; ++n)
+	{
+		if (ctx.g(n) != m_unreached)
+			nearest[n] = ctx.g(n);
+	}
+	nearest[seed] = 0;
+
+	while ((int)m_landmarks.size() < count)
+	{
+		//Furthest node that has arcs and isn't a landmark yet
+		int pick = -1;
+		for (int n = 0; n < nodes; ++n)
+		{
+			if (forward.begin(n) == forward.end(n) && reverse.begin(n) == reverse.end(n))
+				continue;
+
+			if (nearest[n] > 0 && (pick == -1 || nearest[n] > nearest[pick]))
+				pick = n;
+		}
+
+		//Every node is a landmark already
+		if (pick == -1)
+			break;
+
+		m_landmarks.push_back(pick);
+
+		//Costs out of the landmark
+		aStarSearch(forward, ctx, pick, -1, ZeroHeuristic());
+		fromRows.push_back(std::vector<ArcType>(nodes));
+		for (int n = 0; n < nodes; ++n)
+		{
+			fromRows.back()[n] = ctx.g(n);
+			if (ctx.g(n) < nearest[n])
+				nearest[n] = ctx.g(n);
+		}
+
+		//Costs into the landmark
+		aStarSearch(reverse, ctx, pick, -1, ZeroHeuristic());
+		toRows.push_back(std::vector<ArcType>(nodes));
+		for (int n = 0; n < nodes; ++n)
+			toRows.back()[n] = ctx.g(n);
+	}
+
+	//Interleave so one node's landmarks share a cache line
+	m_nodes = nodes;
+	m_count = m_landmarks.size();
+	m_from.resize((size_t)nodes * m_count);
+	m_to.resize((size_t)nodes * m_count);
+
+	for (int n = 0; n < nodes; ++n)
+	{
+		for (int i = 0; i < m_count; ++i)
+		{
+			m_from[(size_t)n * m_count + i] = fromRows[i][n];
+			m_to[(size_t)n * m_count + i] = toRows[i][n];
+		}
+	}
+}
+
+template<class ArcType>
+float LandmarkTable<ArcType>::estimate(int node, int target) const
+{
+	if (m_count == 0 || node >= m_nodes || target >= m_nodes)
+		return 0;
+
+	ArcType const * fromNode = &m_from[(size_t)node * m_count];
+	ArcType const * fromTarget = &m_from[(size_t)target * m_count];
+	ArcType const * toNode = &m_to[(size_t)node * m_count];
+	ArcType const * toTarget = &m_to[(size_t)target * m_count];
+
+	float best = 0;
+	for (int i = 0; i < m_count; ++i)
+	{
+		//d(L, t) - d(L, v)
+		if (fromNode[i] != m_unreached && fromTarget[i] != m_unreached && fromTarget[i] - fromNode[i] > best)
+			best = fromTarget[i] - fromNode[i];
+
+		//d(v, L) - d(t, L)
+		if (toNode[i] != m_unreached && toTarget[i] != m_unreached && toNode[i] - toTarget[i] > best)
+			best = toNode[i] - toTarget[i];
+	}
+
+	return best;
+}
+
+#endif
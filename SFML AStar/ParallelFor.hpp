@@ -0,0 +1,277 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------
+//  Name:           workerCount
+//  Description:    Number of threads parallelFor will use.
+//  Arguments:      The first parameter is the number of work items
+//                  The second is the requested thread count, 0 for
+//                  one per hardware thread.
+//  Return Value:   Thread count, at least 1 and at most count.
+// ----------------------------------------------------------------
+inline int workerCount(int count, int threads = 0)
+{
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+
+	if (threads > count)
+		threads = count;
+
+	return threads < 1 ? 1 : threads;
+}
+
+// ----------------------------------------------------------------
+//  Name:           WorkerPool
+//  Description:    Threads kept alive between parallelFor calls, so
+//                  a call only pays a wake up rather than a thread
+//                  start. Grows when a call asks for more threads
+//                  than it has, never shrinks.
+// ----------------------------------------------------------------
+class WorkerPool {
+private:
+	std::vector<std::thread> m_threads; //Workers, thread t runs job(t + 1)
+	std::mutex m_submit; //One job at a time
+	std::mutex m_lock; //Guards everything below
+	std::condition_variable m_wake; //Signalled when a job starts
+	std::condition_variable m_done; //Signalled when a worker finishes
+	std::function<void(int)> const* m_job; //Current job
+	int m_active; //Threads taking part in the current job, caller included
+	int m_pending; //Workers still running the current job
+	unsigned m_generation; //Bumped for every job
+	bool m_stop; //Set on destruction
+
+	WorkerPool() : m_job(0), m_active(0), m_pending(0), m_generation(0), m_stop(false) {}
+	WorkerPool(WorkerPool const &);
+	WorkerPool& operator=(WorkerPool const &);
+
+	//Set on the pool threads and on a caller while it runs a job
+	static bool& busy() { static thread_local bool t_busy = false; return t_busy; }
+
+	void work(int thread);
+
+public:
+	~WorkerPool();
+
+	static WorkerPool& instance() { static WorkerPool pool; return pool; }
+
+	void run(int threads, std::function<void(int)> const & job);
+};
+
+inline WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_stop = true;
+	}
+
+	m_wake.notify_all();
+
+	for (int t = 0, c = (int)m_threads.size(); t < c; ++t)
+		m_threads[t].join();
+}
+
+inline void WorkerPool::work(int thread)
+{
+	busy() = true;
+	unsigned seen = 0;
+
+	for (;;)
+	{
+		std::function<void(int)> const* job;
+		{
+			std::unique_lock<std::mutex> guard(m_lock);
+			m_wake.wait(guard, [&] { return m_stop || m_generation != seen; });
+
+			if (m_stop)
+				return;
+
+			seen = m_generation;
+
+			//Not needed this time round
+			if (thread >= m_active)
+				continue;
+
+			job = m_job;
+		}
+
+		(*job)(thread);
+
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (--m_pending == 0)
+			m_done.notify_one();
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           run
+//  Description:    Calls job(thread) once for each thread in
+//                  [0, threads), thread 0 on the calling thread.
+//                  Calls made from inside a job run on the calling
+//                  thread alone, so nesting cannot deadlock.
+//  Arguments:      The first parameter is the thread count
+//                  The second is the function to call.
+//  Return Value:   None, returns once every call is done.
+// ----------------------------------------------------------------
+inline void WorkerPool::run(int threads, std::function<void(int)> const & job)
+{
+	if (threads <= 1 || busy())
+	{
+		job(0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> submit(m_submit);
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+
+		while ((int)m_threads.size() < threads - 1)
+			m_threads.push_back(std::thread(&WorkerPool::work, this, (int)m_threads.size() + 1));
+
+		m_job = &job;
+		m_active = threads;
+		m_pending = threads - 1;
+		++m_generation;
+	}
+
+	m_wake.notify_all();
+
+	busy() = true;
+	job(0);
+	busy() = false;
+
+	std::unique_lock<std::mutex> guard(m_lock);
+	m_done.wait(guard, [&] { return m_pending == 0; });
+	m_job = 0;
+}
+
+//Range of work items owned by one worker, thieves take from the back
+struct WorkRange {
+	std::mutex lock;
+	int begin;
+	int end;
+};
+
+// ----------------------------------------------------------------
+//  Name:           takeWork
+//  Description:    Takes the next item from the front of a range.
+//  Return Value:   False if the range is empty.
+// ----------------------------------------------------------------
+inline bool takeWork(WorkRange& range, int& item)
+{
+	std::lock_guard<std::mutex> guard(range.lock);
+
+	if (range.begin == range.end)
+		return false;
+
+	item = range.begin++;
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           stealWork
+//  Description:    Moves the back half of the fullest other range
+//                  into an empty range.
+//  Return Value:   False if there was nothing left to steal.
+// ----------------------------------------------------------------
+inline bool stealWork(std::vector<WorkRange>& ranges, int thief)
+{
+	for (;;)
+	{
+		//Find the victim with the most work left
+		int victim = -1;
+		int most = 0;
+
+		for (int r = 0, c = (int)ranges.size(); r < c; ++r)
+		{
+			if (r == thief)
+				continue;
+
+			std::lock_guard<std::mutex> guard(ranges[r].lock);
+			if (ranges[r].end - ranges[r].begin > most)
+			{
+				most = ranges[r].end - ranges[r].begin;
+				victim = r;
+			}
+		}
+
+		if (victim == -1)
+			return false;
+
+		int begin, end;
+		{
+			std::lock_guard<std::mutex> guard(ranges[victim].lock);
+			int left = ranges[victim].end - ranges[victim].begin;
+
+			//Someone else got there first, look again
+			if (left == 0)
+				continue;
+
+			end = ranges[victim].end;
+			begin = end - (left + 1) / 2;
+			ranges[victim].end = begin;
+		}
+
+		std::lock_guard<std::mutex> guard(ranges[thief].lock);
+		ranges[thief].begin = begin;
+		ranges[thief].end = end;
+		return true;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           parallelFor
+//  Description:    Calls func(item, thread) for every item in
+//                  [0, count) across the shared WorkerPool. Each thread
+//                  starts with an even slice and steals half of the
+//                  busiest slice when it runs dry, so uneven items
+//                  still keep every thread busy.
+//  Arguments:      The first parameter is the number of items
+//                  The second is the function to call
+//                  The third is the thread count, see workerCount.
+//  Return Value:   None, returns once every item is done.
+// ----------------------------------------------------------------
+template<class Func>
+void parallelFor(int count, Func func, int threads = 0)
+{
+	threads = workerCount(count, threads);
+
+	//Not worth starting threads for
+	if (threads == 1)
+	{
+		for (int item = 0; item < count; ++item)
+			func(item, 0);
+		return;
+	}
+
+	//Even starting slices
+	std::vector<WorkRange> ranges(threads);
+	for (int t = 0; t < threads; ++t)
+	{
+		ranges[t].begin = (int)((long long)count * t / threads);
+		ranges[t].end = (int)((long long)count * (t + 1) / threads);
+	}
+
+	auto worker = [&](int thread)
+	{
+		int item;
+		for (;;)
+		{
+			if (takeWork(ranges[thread], item))
+				func(item, thread);
+			else if (!stealWork(ranges, thread))
+				break;
+		}
+	};
+
+	//The calling thread works too
+	WorkerPool::instance().run(threads, std::function<void(int)>(worker));
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef SEARCHBUDGET_H
+#define SEARCHBUDGET_H
+
+#include <chrono>
+#include <climits>
+
+//How a search ended, Complete unless a limit stopped it
+enum SearchStatus {
+	Complete, //Reached the target, or searched everything there was
+	Unreachable, //Ran out of nodes before reaching the target
+	ExpansionLimit, //Expanded as many nodes as it was allowed
+	CostLimit, //Every route left would cost more than allowed
+	DeadlineReached //Out of time
+};
+
+// ----------------------------------------------------------------
+//  Name:           SearchBudget
+//  Description:    Limits on one search, kept on its SearchContext so
+//                  every search run on that context keeps to them. The
+//                  defaults are no limits at all.
+//
+//                  maxCost is checked against g of the node about to
+//                  be expanded, so the search stops once every route
+//                  left costs more even if the heuristic overestimates.
+//                  It's only checked if set. The clock is only read
+//                  every 64 expansions.
+//                  partialPath asks getPath for the route to the
+//                  closest node reached (lowest h) when a limit stops
+//                  the search, rather than the target alone.
+// ----------------------------------------------------------------
+struct SearchBudget {
+	typedef std::chrono::steady_clock Clock;
+
+	int maxExpansions; //0 for no limit
+	float maxCost;
+	Clock::time_point deadline;
+	bool partialPath;
+
+	SearchBudget() : maxExpansions(0), maxCost((float)INT_MAX), deadline(Clock::time_point::max()), partialPath(false) {}
+
+	//Deadline this far from now
+	void setTimeLimit(double seconds)
+	{
+		deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	}
+
+	bool costLimited() const { return maxCost < (float)INT_MAX; }
+	bool limited() const { return maxExpansions > 0 || costLimited() || deadline != Clock::time_point::max(); }
+
+	//Checked before each expansion, with the count so far and g of the node to expand
+	SearchStatus check(int expanded, float g) const
+	{
+		if (maxExpansions > 0 && expanded >= maxExpansions)
+			return ExpansionLimit;
+		if (costLimited() && g > maxCost)
+			return CostLimit;
+		if ((expanded & 63) == 0 && deadline != Clock::time_point::max() && Clock::now() >= deadline)
+			return DeadlineReached;
+		return Complete;
+	}
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef SEARCHCONTEXT_H
+#define SEARCHCONTEXT_H
+
+#include <climits>
+#include <vector>
+
+#include "IndexedHeap.hpp"
+#include "SearchBudget.hpp"
+
+// ----------------------------------------------------------------
+//  Name:           SearchContext
+//  Description:    Scratch state for one search, kept as parallel
+//                  arrays indexed by node index. The graph itself is
+//                  only read during a search, so any number of
+//                  contexts can search the same graph at once.
+//                  Entries are stamped with the generation that wrote
+//                  them, so starting a new search just bumps the
+//                  generation and stale entries read as unreached.
+// ----------------------------------------------------------------
+template<class ArcType>
+class SearchContext {
+private:
+	std::vector<ArcType> m_g; //Actual distance, used for UCS and A*
+	std::vector<float> m_h; //Heuristic, used for A*
+	std::vector<int> m_prev; //Index of the previous node on the path, -1 for none
+	std::vector<char> m_marked; //Reached by the search (queued or popped)
+	std::vector<unsigned> m_stamp; //Generation that last wrote g, prev and marked
+	std::vector<unsigned> m_hStamp; //Generation that last wrote h
+
+	unsigned m_generation; //Current search generation
+	unsigned m_hGeneration; //Current heuristic generation
+
+	IndexedHeap<float> m_open; //Open list, keyed by node index
+
+	ArcType m_maxG; //G of a node that hasn't been reached
+	float m_maxH; //H of a node with no heuristic
+
+	SearchBudget m_budget; //Limits on every search run on this context
+	SearchStatus m_status; //How the last search ended
+	int m_closest; //Popped node with the lowest h, -1 if not tracked
+
+public:
+	SearchContext() : m_generation(1), m_hGeneration(1), m_maxG(INT_MAX - 20000), m_maxH(INT_MAX - 20000), m_status(Complete), m_closest(-1) {}
+	explicit SearchContext(int size) : m_generation(1), m_hGeneration(1), m_maxG(INT_MAX - 20000), m_maxH(INT_MAX - 20000), m_status(Complete), m_closest(-1) { resize(size); }
+
+	//Number of nodes this context can hold
+	void resize(int size);
+	int size() const { return (int)m_g.size(); }
+
+	// Accessors, stale entries read as unreached
+	bool touched(int node) const { return m_stamp[node] == m_generation; }
+	ArcType g(int node) const { return touched(node) ? m_g[node] : m_maxG; }
+	float h(int node) const { return m_hStamp[node] == m_hGeneration ? m_h[node] : m_maxH; }
+	int prev(int node) const { return touched(node) ? m_prev[node] : -1; }
+	bool marked(int node) const { return touched(node) && m_marked[node] != 0; }
+	bool closed(int node) const { return marked(node) && !m_open.contains(node); }
+	ArcType maxG() const { return m_maxG; }
+	float maxH() const { return m_maxH; }
+	IndexedHeap<float> & open() { return m_open; }
+	SearchBudget const & budget() const { return m_budget; }
+	SearchStatus status() const { return m_status; }
+	int closest() const { return m_closest; }
+
+	// Manipulators
+	void setG(int node, ArcType g) { touch(node); m_g[node] = g; }
+	void setH(int node, float h) { m_hStamp[node] = m_hGeneration; m_h[node] = h; }
+	void setPrev(int node, int prev) { touch(node); m_prev[node] = prev; }
+	void setMarked(int node, bool mark) { touch(node); m_marked[node] = mark; }
+	void setBudget(SearchBudget const & budget) { m_budget = budget; }
+	void setStatus(SearchStatus status, int closest) { m_status = status; m_closest = closest; }
+
+	//Preparations, both O(1) apart from emptying the open list
+	void reset();
+	void resetH();
+
+private:
+	void touch(int node);
+};
+
+template<class ArcType>
+void SearchContext<ArcType>::resize(int size)
+{
+	m_g.resize(size, m_maxG);
+	m_h.resize(size, m_maxH);
+	m_prev.resize(size, -1);
+	m_marked.resize(size, 0);
+	m_stamp.resize(size, 0);
+	m_hStamp.resize(size, 0);
+	m_open.resize(size);
+}
+
+// ----------------------------------------------------------------
+//  Name:           touch
+//  Description:    Brings a node's g, prev and marked up to the
+//                  current generation before one of them is written.
+// ----------------------------------------------------------------
+template<class ArcType>
+void SearchContext<ArcType>::touch(int node)
+{
+	if (m_stamp[node] != m_generation)
+	{
+		m_stamp[node] = m_generation;
+		m_g[node] = m_maxG;
+		m_prev[node] = -1;
+		m_marked[node] = 0;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           reset
+//  Description:    Unmarks every node, clears every prev and maxes
+//                  every g by starting a new generation. The budget
+//                  is kept for the next search.
+// ----------------------------------------------------------------
+template<class ArcType>
+void SearchContext<ArcType>::reset()
+{
+	m_open.clear();
+	m_status = Complete;
+	m_closest = -1;
+
+	//Stamps only need wiping when the counter wraps
+	if (++m_generation == 0)
+	{
+		m_stamp.assign(m_stamp.size(), 0);
+		m_generation = 1;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           resetH
+//  Description:    Maxes every h by starting a new heuristic
+//                  generation. Kept apart from reset() so a heuristic
+//                  can be filled in before the search that uses it.
+// ----------------------------------------------------------------
+template<class ArcType>
+void SearchContext<ArcType>::resetH()
+{
+	if (++m_hGeneration == 0)
+	{
+		m_hStamp.assign(m_hStamp.size(), 0);
+		m_hGeneration = 1;
+	}
+}
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef TEXTLOADER_H
+#define TEXTLOADER_H
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Graph.hpp"
+#include "ParallelFor.hpp"
+
+// ----------------------------------------------------------------
+//  Loader for the text graph files main.cpp reads ("data x y" per
+//  node, "from to weight" per arc). The whole file is read at once,
+//  cut into chunks at line breaks, and the chunks are parsed on
+//  separate threads with the small parsers below instead of
+//  ifstream >>. Arcs go into the graph through GraphCSR::build and
+//  Graph::addArcs in one pass.
+// ----------------------------------------------------------------
+
+//Spaces and tabs, never a line break so a short line can't run into the next
+inline char const * skipBlanks(char const * p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\r')
+		++p;
+	return p;
+}
+
+//Fast integer parser, the buffer must end in a '\0'
+inline bool parseValue(char const *& p, int& out)
+{
+	p = skipBlanks(p);
+
+	bool negative = *p == '-';
+	if (*p == '-' || *p == '+')
+		++p;
+
+	if (*p < '0' || *p > '9')
+		return false;
+
+	int value = 0;
+	while (*p >= '0' && *p <= '9')
+		value = value * 10 + (*p++ - '0');
+
+	out = negative ? -value : value;
+	return true;
+}
+
+inline bool parseValue(char const *& p, double& out)
+{
+	p = skipBlanks(p);
+
+	char* end;
+	out = strtod(p, &end);
+	if (end == p)
+		return false;
+
+	p = end;
+	return true;
+}
+
+inline bool parseValue(char const *& p, float& out)
+{
+	double value;
+	if (!parseValue(p, value))
+		return false;
+
+	out = (float)value;
+	return true;
+}
+
+//Single character node data, like the char graphs main.cpp loads
+inline bool parseValue(char const *& p, char& out)
+{
+	p = skipBlanks(p);
+	if (*p == '\0' || *p == '\n')
+		return false;
+
+	out = *p++;
+	return true;
+}
+
+//Whole file plus a '\0' so the parsers can't run off the end
+inline bool readWholeFile(std::string const & filename, std::vector<char>& buffer)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+
+	std::streamoff size = file.tellg();
+	file.seekg(0);
+
+	buffer.resize((size_t)size + 1);
+	file.read(buffer.data(), size);
+	buffer[(size_t)size] = '\0';
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           parseRecords
+//  Description:    Parses three values per line from a buffer, in
+//                  parallel chunks that each start on a line. Lines
+//                  that don't parse are skipped. The records come out
+//                  in file order.
+//  Arguments:      The first parameter is the buffer from readWholeFile
+//                  The next three receive the columns
+//                  The last is the thread count, see workerCount.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class A, class B, class C>
+void parseRecords(std::vector<char> const & buffer, std::vector<A>& first, std::vector<B>& second, std::vector<C>& third, int threads = 0)
+{
+	size_t size = buffer.size() - 1;
+
+	//A few chunks per thread so stealing can even out, but not tiny ones
+	const size_t minChunk = 1 << 16;
+	int chunks = workerCount((int)(size / minChunk) + 1, threads) * 4;
+
+	//Chunk starts, moved forward to just past a line break
+	std::vector<size_t> bounds(chunks + 1, size);
+	bounds[0] = 0;
+	for (int c = 1; c < chunks; ++c)
+	{
+		size_t at = size * c / chunks;
+		if (at < bounds[c - 1])
+			at = bounds[c - 1];
+
+		//A start of 0 is already on a line, files shorter than chunks round down to it
+		while (at > 0 && at < size && buffer[at - 1] != '\n')
+			++at;
+		bounds[c] = at;
+	}
+
+	std::vector<std::vector<A>> firsts(chunks);
+	std::vector<std::vector<B>> seconds(chunks);
+	std::vector<std::vector<C>> thirds(chunks);
+
+	parallelFor(chunks, [&](int c, int)
+	{
+		char const * p = buffer.data() + bounds[c];
+		char const * end = buffer.data() + bounds[c + 1];
+
+		//Rough guess of 12 bytes a line
+		size_t guess = (end - p) / 12;
+		firsts[c].reserve(guess);
+		seconds[c].reserve(guess);
+		thirds[c].reserve(guess);
+
+		while (p < end)
+		{
+			A a;
+			B b;
+			C v;
+			if (parseValue(p, a) && parseValue(p, b) && parseValue(p, v))
+			{
+				firsts[c].push_back(a);
+				seconds[c].push_back(b);
+				thirds[c].push_back(v);
+			}
+
+			//On to the next line, whatever is left of this one
+			while (*p != '\n' && *p != '\0')
+				++p;
+			if (*p == '\n')
+				++p;
+			else break;
+		}
+	}, threads);
+
+	//Stitch the chunks back together in order
+	size_t total = 0;
+	for (int c = 0; c < chunks; ++c)
+		total += firsts[c].size();
+
+	first.clear();
+	second.clear();
+	third.clear();
+	first.reserve(total);
+	second.reserve(total);
+	third.reserve(total);
+
+	for (int c = 0; c < chunks; ++c)
+	{
+		first.insert(first.end(), firsts[c].begin(), firsts[c].end());
+		second.insert(second.end(), seconds[c].begin(), seconds[c].end());
+		third.insert(third.end(), thirds[c].begin(), thirds[c].end());
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           loadTextGraph
+//  Description:    Loads a node file and an arc file into a graph.
+//                  Nodes get ids in file order after any the graph
+//                  already has, and the arc file's ids are moved along
+//                  with them, so loading into a graph that has nodes
+//                  adds a separate piece. Arcs naming a node the file
+//                  doesn't have are dropped. Repeated arcs keep the
+//                  first weight, as addDualArc and addArc do. Both
+//                  files are read before the graph is touched.
+//  Arguments:      The first parameter is the graph to load into
+//                  The next two are the node and arc files
+//                  The fourth adds each arc both ways if set, like
+//                  loadGraphDrawable
+//                  The last is the thread count, see workerCount.
+//  Return Value:   False if a file couldn't be read, the graph is
+//                  left as it was then.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool loadTextGraph(Graph<NodeType, ArcType>& graph, std::string const & nodesFile, std::string const & arcsFile, bool dual = true, int threads = 0)
+{
+	std::vector<char> nodeBuffer;
+	std::vector<char> arcBuffer;
+	if (!readWholeFile(nodesFile, nodeBuffer) || !readWholeFile(arcsFile, arcBuffer))
+		return false;
+
+	std::vector<NodeType> data;
+	std::vector<float> xs, ys;
+	parseRecords(nodeBuffer, data, xs, ys, threads);
+
+	std::vector<int> from, to;
+	std::vector<ArcType> weights;
+	parseRecords(arcBuffer, from, to, weights, threads);
+
+	//Nodes
+	int first = graph.slotCount();
+	int count = (int)data.size();
+	graph.reserve(first + count);
+	for (int i = 0; i < count; ++i)
+	{
+		graph.addNode(data[i], first + i);
+		graph.nodeArray()[first + i]->setPosition(sf::Vector2f(xs[i], ys[i]));
+	}
+
+	//Arcs, onto the new ids. Ones outside the file are made negative so the build skips them
+	for (int i = 0, c = (int)from.size(); i < c; ++i)
+	{
+		bool inFile = from[i] >= 0 && to[i] >= 0 && from[i] < count && to[i] < count;
+		from[i] = inFile ? from[i] + first : -1;
+		to[i] = inFile ? to[i] + first : -1;
+	}
+
+	GraphCSR<ArcType> arcs;
+	arcs.build(graph.slotCount(), from, to, weights, dual);
+	graph.addArcs(arcs);
+
+	return true;
+}
+
+#endif
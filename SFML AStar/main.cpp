@@ -26,6 +26,7 @@
 #include <algorithm>
 
 #include "Graph.hpp"
+#include "TextLoader.hpp"
 
 using std::cout;
 using std::endl;
@@ -37,11 +38,6 @@ typedef GraphNode<char, int> Node;
 
 typedef vector<Node*> Path;
 
-//Vector of <endNode, heuristic>
-typedef vector<pair<char, int>> HeurVec;
-//Heuristic map is a vector<startNode, vector<endNode, heuristic>>
-typedef vector<pair<char, HeurVec>> HeurMap;
-
 ////////////////////////////////////////////////////////////
 ///Global Variables
 //////////////////////////////////////////////////////////// 
@@ -65,13 +61,14 @@ sf::Vector2f tOrigin;
 sf::FloatRect btnUCSPF;
 sf::FloatRect btnAStar;
 sf::FloatRect btnPrcmp;
+sf::FloatRect btnLndmk;
 sf::FloatRect btnRandm;
 sf::FloatRect btnSwaps;
 sf::FloatRect btnReset;
 sf::Color cBtn, cBtnHover, cBtnPress, cTxt, cTxtHover, cTxtPress;
 
 //Graph, path, start and end nodes
-Graph<char, int> graph(30);
+Graph<char, int> graph; //Grows as the loader adds nodes
 Path path;
 Node* nStart;
 Node* nEnd;
@@ -98,12 +95,12 @@ void visit(Node * pNode) {
 }
 
 void trackback(Node * pNode) {
-	cout << "\t" << "Trackback: " << pNode->data() << ", " << pNode->g() << endl;
+	cout << "\t" << "Trackback: " << pNode->data() << ", " << graph.g(pNode) << endl;
 }
 
 void found(Node * pNode)
 {
-	cout << "\t" << "Found: " << pNode->data() << ", " << pNode->g() << endl;
+	cout << "\t" << "Found: " << pNode->data() << ", " << graph.g(pNode) << endl;
 }
 
 void outputUCSPath(Path* p)
@@ -117,8 +114,8 @@ void outputUCSPath(Path* p)
 	int lastCost = 0;
 	//Using path to track back
 	for (; vIter != vEnd; ++vIter) {
-		cout << "\t" << "Node: " << (*vIter)->data() << " (" << (*vIter)->g() - lastCost << ")" << endl;
-		lastCost = (*vIter)->g();
+		cout << "\t" << "Node: " << (*vIter)->data() << " (" << graph.g(*vIter) - lastCost << ")" << endl;
+		lastCost = graph.g(*vIter);
 	}
 
 	cout << endl;
@@ -134,7 +131,7 @@ void outputUCSPathShort(Path* p)
 	Path::iterator vLast = --p->end();
 	Path::iterator vEnd = p->end();
 
-	cout << "[" << (*vIter)->data() << "-" << (*--p->end())->data() << "]" << " [" << (*--p->end())->g() << "]" << endl;
+	cout << "[" << (*vIter)->data() << "-" << (*--p->end())->data() << "]" << " [" << graph.g(*--p->end()) << "]" << endl;
 	cout << "\t";
 
 	int lastCost = 0;
@@ -143,11 +140,11 @@ void outputUCSPathShort(Path* p)
 
 		if (vIter != vStart)
 		{
-			cout << "(" << (*vIter)->g() - lastCost << ")-";
+			cout << "(" << graph.g(*vIter) - lastCost << ")-";
 		}
 
 		cout << (*vIter)->data();
-		lastCost = (*vIter)->g();
+		lastCost = graph.g(*vIter);
 
 		if (vIter != vLast)
 		{
@@ -164,7 +161,7 @@ void outputAstarPathShort(Path* p)
 	Path::iterator vLast = --p->end();
 	Path::iterator vEnd = p->end();
 
-	cout << "[" << (*vIter)->data() << "-" << (*--p->end())->data() << "]" << " [" << (*--p->end())->g() << "]" << endl;
+	cout << "[" << (*vIter)->data() << "-" << (*--p->end())->data() << "]" << " [" << graph.g(*--p->end()) << "]" << endl;
 	cout << "\t";
 
 	int lastCost = 0;
@@ -173,11 +170,11 @@ void outputAstarPathShort(Path* p)
 
 		if (vIter != vStart)
 		{
-			cout << "(" << (*vIter)->g() - lastCost << ")-";
+			cout << "(" << graph.g(*vIter) - lastCost << ")-";
 		}
 
 		cout << (*vIter)->data();
-		lastCost = (*vIter)->g();
+		lastCost = graph.g(*vIter);
 
 		if (vIter != vLast)
 		{
@@ -218,48 +215,30 @@ void loadGraph(GraphType &g, string nodes, string arcs)
 	//read arcs
 	myfile.open(arcs);
 
+	//No duplicate check per arc, repeats are removed once at the end
+	g.beginBulk();
+
 	int n1, n2, weight;
 	while (myfile >> n1 >> n2 >> weight) {
 		g.addDualArc(n1, n2, weight);
 	}
 
+	g.endBulk();
+
 	myfile.close();
 }
 
 void loadGraphDrawable(GraphType & g, string nodes, string arcs)
 {
-	//read nodes
-	char c;
-
-	int i = 0;
-	int x = 0;
-	int y = 0;
-	ifstream myfile;
-
-	myfile.open(nodes);
-
-	while (myfile >> c >> x >> y) {
-		g.addNode(c, i);
-		g.nodeArray()[i]->setPosition(sf::Vector2f(x, y));
-		++i;
-	}
-
-	myfile.close();
-
-	//read arcs
-	myfile.open(arcs);
-
-	int from, to, weight;
-	while (myfile >> from >> to >> weight) {
-		g.addDualArc(from, to, weight);
-	}
-
-	myfile.close();
+	//Chunked parallel parse and one bulk arc pass, see TextLoader.hpp
+	loadTextGraph(g, nodes, arcs);
 }
 
 float distanceBetween(const sf::Vector2f v1, const sf::Vector2f v2)
 {
-	return sqrt(pow(v2.x - v1.x, 2) + pow(v2.y - v1.y, 2));
+	float dx = v2.x - v1.x;
+	float dy = v2.y - v1.y;
+	return sqrt(dx * dx + dy * dy);
 }
 
 sf::Vector2f midpoint(const sf::Vector2f v1, const sf::Vector2f v2)
@@ -324,19 +303,13 @@ void drawPath(sf::RenderWindow & w, Path & p)
 	if (p.empty())
 		return;
 
-	//Draw Arcs
-	for (Path::iterator vIter = p.begin(), vEnd = p.end(); vIter != vEnd; ++vIter)
+	//Draw Arcs between each node and the one before it, so paths from any search draw the same
+	for (Path::iterator vPrev = p.begin(), vIter = vPrev + 1, vEnd = p.end(); vIter != vEnd; vPrev = vIter++)
 	{
-		Node* tempNode = (*vIter);
-
-		//If we have no previous, skip drawing
-		if (tempNode->getPrev() == NULL)
-			continue;
-
 		sf::Vertex line[] =
 		{
-			sf::Vertex(tempNode->position() + b, cPathArc),
-			sf::Vertex(tempNode->getPrev()->position() + b, cPathArc)
+			sf::Vertex((*vIter)->position() + b, cPathArc),
+			sf::Vertex((*vPrev)->position() + b, cPathArc)
 		};
 
 		w.draw(line, 2, sf::Lines);
@@ -357,7 +330,7 @@ void drawArcs(sf::RenderWindow & w, GraphType & const g)
 
 		drawnNodes.push_back(tempNode->data());
 
-		for (list<Arc>::const_iterator vIter = tempNode->arcList().begin(), vEnd = tempNode->arcList().end(); vIter != vEnd; ++vIter)
+		for (Node::ArcList::const_iterator vIter = tempNode->arcList().begin(), vEnd = tempNode->arcList().end(); vIter != vEnd; ++vIter)
 		{
 
 			bool drawn = std::find(drawnNodes.begin(), drawnNodes.end(), vIter->node()->data()) != drawnNodes.end();
@@ -431,7 +404,7 @@ void drawNodes(sf::RenderWindow & const w, GraphType & const g, Path & p)
 			circ.setFillColor(cPathNode);
 		}
 
-		else if (tempNode->marked())
+		else if (graph.marked(tempNode))
 		{
 			circ.setFillColor(cExp);
 		}
@@ -467,13 +440,13 @@ void drawNodes(sf::RenderWindow & const w, GraphType & const g, Path & p)
 			t.setPosition((tempNode->position() + b) - sf::Vector2f(nodeRadius / 2, nodeRadius / 2));
 
 			//Correct for max
-			int g = tempNode->g();
-			if (g >= maxG)
+			int nodeG = graph.g(tempNode);
+			if (nodeG >= maxG)
 			{
 				t.setString(maxstr);
 			}
 
-			else t.setString(numToStr(g));
+			else t.setString(numToStr(nodeG));
 
 			t.setColor(cG);
 			w.draw(t);
@@ -485,13 +458,13 @@ void drawNodes(sf::RenderWindow & const w, GraphType & const g, Path & p)
 			t.setCharacterSize(fH);
 			t.setPosition((tempNode->position() + b) + sf::Vector2f(nodeRadius * 1.5, nodeRadius * 2));
 
-			float h = tempNode->h();
+			float h = graph.h(tempNode);
 			if (h >= maxH)
 			{
 				t.setString(maxstr);
 			}
 
-			else t.setString(numToStr(tempNode->h()));
+			else t.setString(numToStr(graph.h(tempNode)));
 
 			t.setColor(cH);
 			w.draw(t);
@@ -578,6 +551,7 @@ void drawMenu(sf::RenderWindow & const w)
 	drawButton(w, btnUCSPF, "UCS");
 	drawButton(w, btnAStar, "AStar");
 	drawButton(w, btnPrcmp, "Map");
+	drawButton(w, btnLndmk, "ALT");
 	drawButton(w, btnSwaps, "Swap");
 	drawButton(w, btnRandm, "Random");
 	drawButton(w, btnReset, "Reset");
@@ -710,6 +684,19 @@ bool clickBtn(const sf::RenderWindow & const w)
 			action = true;
 		}
 
+		//Pick landmarks/run landmark A*
+		else if (mouseOverButton(btnLndmk, w))
+		{
+			if (!graph.hasLandmarks())
+				graph.genLandmarks();
+
+			else if (nStart != NULL && nEnd != NULL)
+			{
+				graph.AStarLandmark(nStart, nEnd, path);
+			}
+			action = true;
+		}
+
 		//Switch start and end
 		else if (mouseOverButton(btnSwaps, w))
 		{
@@ -812,6 +799,7 @@ int main()
 	btnUCSPF = sf::FloatRect(560, b.y * 0, 64, b.y);
 	btnAStar = sf::FloatRect(560, b.y * 1.5, 64, b.y);
 	btnPrcmp = sf::FloatRect(560, b.y * 3, 64, b.y);
+	btnLndmk = sf::FloatRect(560, b.y * 4.5, 64, b.y);
 
 	btnSwaps = sf::FloatRect(640, b.y * 0, 64, b.y);
 	btnRandm = sf::FloatRect(640, b.y * 1.5, 64, b.y);